@@ -0,0 +1,264 @@
+#include "AnsiTerminal.h"
+
+#include <cstdint>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+// the characters of code page 437 above 127, as the level files and the
+// Windows console have them
+static const uint16_t kCodePage437[128] = {
+	0x00C7, 0x00FC, 0x00E9, 0x00E2, 0x00E4, 0x00E0, 0x00E5, 0x00E7, 0x00EA, 0x00EB, 0x00E8, 0x00EF, 0x00EE, 0x00EC, 0x00C4, 0x00C5,
+	0x00C9, 0x00E6, 0x00C6, 0x00F4, 0x00F6, 0x00F2, 0x00FB, 0x00F9, 0x00FF, 0x00D6, 0x00DC, 0x00A2, 0x00A3, 0x00A5, 0x20A7, 0x0192,
+	0x00E1, 0x00ED, 0x00F3, 0x00FA, 0x00F1, 0x00D1, 0x00AA, 0x00BA, 0x00BF, 0x2310, 0x00AC, 0x00BD, 0x00BC, 0x00A1, 0x00AB, 0x00BB,
+	0x2591, 0x2592, 0x2593, 0x2502, 0x2524, 0x2561, 0x2562, 0x2556, 0x2555, 0x2563, 0x2551, 0x2557, 0x255D, 0x255C, 0x255B, 0x2510,
+	0x2514, 0x2534, 0x252C, 0x251C, 0x2500, 0x253C, 0x255E, 0x255F, 0x255A, 0x2554, 0x2569, 0x2566, 0x2560, 0x2550, 0x256C, 0x2567,
+	0x2568, 0x2564, 0x2565, 0x2559, 0x2558, 0x2552, 0x2553, 0x256B, 0x256A, 0x2518, 0x250C, 0x2588, 0x2584, 0x258C, 0x2590, 0x2580,
+	0x03B1, 0x00DF, 0x0393, 0x03C0, 0x03A3, 0x03C3, 0x00B5, 0x03C4, 0x03A6, 0x0398, 0x03A9, 0x03B4, 0x221E, 0x03C6, 0x03B5, 0x2229,
+	0x2261, 0x00B1, 0x2265, 0x2264, 0x2320, 0x2321, 0x00F7, 0x2248, 0x00B0, 0x2219, 0x00B7, 0x221A, 0x207F, 0x00B2, 0x25A0, 0x00A0
+};
+
+// a screen of its own, what was on it before comes back on leaving it
+const char kEnterScreen[] = "\x1b[?1049h\x1b[?25l";
+const char kLeaveScreen[] = "\x1b[0m\x1b[?25h\x1b[?1049l";
+
+#ifndef _WIN32
+// the signals that end the game without Stop() being called
+static const int kStopSignals[] = { SIGINT, SIGTERM, SIGHUP, SIGQUIT };
+constexpr int kStopSignalCount = sizeof(kStopSignals) / sizeof(kStopSignals[0]);
+
+// a signal handler can't reach the terminal, so what it needs to hand the
+// terminal back is kept here while the game runs
+static termios s_inputSettings;
+static volatile sig_atomic_t s_inputChanged = 0;
+static volatile sig_atomic_t s_onScreen = 0;
+static struct sigaction s_previousActions[kStopSignalCount];
+
+// puts the terminal back the way Stop() would, then lets the signal end
+// the game as it would have
+static void OnStopSignal(int signalNumber)
+{
+	if (s_inputChanged)
+	{
+		tcsetattr(STDIN_FILENO, TCSAFLUSH, &s_inputSettings);
+	}
+	if (s_onScreen)
+	{
+		ssize_t written = write(STDOUT_FILENO, kLeaveScreen, sizeof(kLeaveScreen) - 1);
+		(void)written;
+	}
+
+	signal(signalNumber, SIG_DFL);
+	raise(signalNumber);
+}
+#endif
+
+AnsiTerminal::AnsiTerminal()
+	: m_started(false)
+#ifdef _WIN32
+	, m_console(GetStdHandle(STD_OUTPUT_HANDLE))
+	, m_mode(0)
+	, m_codePage(0)
+#else
+	, m_inputChanged(false)
+	, m_inputSettings()
+#endif
+{
+}
+
+AnsiTerminal::~AnsiTerminal()
+{
+	Stop();
+}
+
+bool AnsiTerminal::Start()
+{
+	if (m_started)
+	{
+		return true;
+	}
+
+#ifdef _WIN32
+	// escape sequences are only understood once asked for, which consoles
+	// before Windows 10 refuse
+	if (!GetConsoleMode(m_console, &m_mode)
+		|| !SetConsoleMode(m_console, m_mode | ENABLE_PROCESSED_OUTPUT | ENABLE_VIRTUAL_TERMINAL_PROCESSING))
+	{
+		return false;
+	}
+	m_codePage = GetConsoleOutputCP();
+	SetConsoleOutputCP(CP_UTF8);
+#else
+	if (!isatty(STDOUT_FILENO))
+	{
+		return false;
+	}
+
+	// keys are read as they are pressed, without showing them. Ctrl+C
+	// still stops the game, and gives the terminal back on the way out
+	if (tcgetattr(STDIN_FILENO, &m_inputSettings) == 0)
+	{
+		termios raw = m_inputSettings;
+		raw.c_lflag &= ~(ICANON | ECHO);
+		raw.c_iflag &= ~(IXON | ICRNL);
+		raw.c_cc[VMIN] = 1;
+		raw.c_cc[VTIME] = 0;
+		m_inputChanged = tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) == 0;
+	}
+
+	s_inputSettings = m_inputSettings;
+	s_inputChanged = m_inputChanged;
+	s_onScreen = 1;
+
+	struct sigaction action = {};
+	action.sa_handler = OnStopSignal;
+	sigemptyset(&action.sa_mask);
+	for (int i = 0; i < kStopSignalCount; ++i)
+	{
+		sigaction(kStopSignals[i], &action, &s_previousActions[i]);
+	}
+#endif
+
+	m_started = true;
+	m_output += kEnterScreen;
+	Flush();
+	return true;
+}
+
+void AnsiTerminal::Stop()
+{
+	if (!m_started)
+	{
+		return;
+	}
+
+	m_output += kLeaveScreen;
+	Flush();
+	m_started = false;
+
+#ifdef _WIN32
+	SetConsoleOutputCP(m_codePage);
+	SetConsoleMode(m_console, m_mode);
+#else
+	for (int i = 0; i < kStopSignalCount; ++i)
+	{
+		sigaction(kStopSignals[i], &s_previousActions[i], nullptr);
+	}
+	s_onScreen = 0;
+	s_inputChanged = 0;
+
+	if (m_inputChanged)
+	{
+		tcsetattr(STDIN_FILENO, TCSAFLUSH, &m_inputSettings);
+		m_inputChanged = false;
+	}
+#endif
+}
+
+void AnsiTerminal::GetSize(int& width, int& height)
+{
+#ifdef _WIN32
+	CONSOLE_SCREEN_BUFFER_INFO csbi;
+	if (GetConsoleScreenBufferInfo(m_console, &csbi))
+	{
+		width = csbi.srWindow.Right - csbi.srWindow.Left + 1;
+		height = csbi.srWindow.Bottom - csbi.srWindow.Top + 1;
+	}
+#else
+	winsize size;
+	if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0 && size.ws_row > 0)
+	{
+		width = size.ws_col;
+		height = size.ws_row;
+	}
+#endif
+}
+
+void AnsiTerminal::Clear()
+{
+	m_output += "\x1b[0m\x1b[2J";
+}
+
+void AnsiTerminal::MoveCursor(int x, int y)
+{
+	m_output += "\x1b[";
+	m_output += std::to_string(y + 1);
+	m_output += ';';
+	m_output += std::to_string(x + 1);
+	m_output += 'H';
+}
+
+void AnsiTerminal::SetColor(int color)
+{
+	// the console's colors have blue in the lowest bit, the terminal's red
+	auto toTerminal = [](int consoleColor) {
+		return ((consoleColor & 1) << 2) | (consoleColor & 2) | ((consoleColor & 4) >> 2);
+	};
+	int foreground = color & 0x0F;
+	int background = (color >> 4) & 0x0F;
+
+	m_output += "\x1b[";
+	m_output += std::to_string(((foreground & 8) != 0 ? 90 : 30) + toTerminal(foreground));
+	m_output += ';';
+	m_output += std::to_string(((background & 8) != 0 ? 100 : 40) + toTerminal(background));
+	m_output += 'm';
+}
+
+void AnsiTerminal::Write(char glyph)
+{
+	uint8_t code = static_cast<uint8_t>(glyph);
+	if (code < 0x80)
+	{
+		m_output += glyph;
+		return;
+	}
+
+	// all of them fit in 2 or 3 bytes
+	uint16_t codePoint = kCodePage437[code - 0x80];
+	if (codePoint < 0x800)
+	{
+		m_output += static_cast<char>(0xC0 | (codePoint >> 6));
+	}
+	else
+	{
+		m_output += static_cast<char>(0xE0 | (codePoint >> 12));
+		m_output += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+	}
+	m_output += static_cast<char>(0x80 | (codePoint & 0x3F));
+}
+
+void AnsiTerminal::Flush()
+{
+	if (!m_output.empty())
+	{
+		WriteOutput(m_output);
+		m_output.clear();
+	}
+}
+
+void AnsiTerminal::WriteOutput(const std::string& output)
+{
+#ifdef _WIN32
+	DWORD written = 0;
+	WriteConsoleA(m_console, output.data(), static_cast<DWORD>(output.size()), &written, nullptr);
+#else
+	size_t offset = 0;
+	while (offset < output.size())
+	{
+		ssize_t written = write(STDOUT_FILENO, output.data() + offset, output.size() - offset);
+		if (written < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (written <= 0)
+		{
+			break;
+		}
+		offset += static_cast<size_t>(written);
+	}
+#endif
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "Terminal.h"
+
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <termios.h>
+#endif
+
+// Virtual terminal escape sequences, for terminals on Linux and consoles
+// on Windows 10 and later. Everything written until Flush() goes out in one
+// write. Glyphs are sent as UTF-8 so they look the same whatever code page
+// the terminal is set to. On Linux it also stops the terminal from
+// echoing keys and holding them back until enter is pressed, and puts it
+// back when Ctrl+C or another signal ends the game
+class AnsiTerminal : public Terminal
+{
+public:
+	AnsiTerminal();
+	~AnsiTerminal();
+
+	virtual bool Start() override;
+	virtual void Stop() override;
+	virtual void GetSize(int& width, int& height) override;
+
+	virtual void Clear() override;
+	virtual void MoveCursor(int x, int y) override;
+	virtual void SetColor(int color) override;
+	virtual void Write(char glyph) override;
+	virtual void Flush() override;
+
+private:
+	void WriteOutput(const std::string& output);
+
+	bool m_started;
+	std::string m_output;
+
+#ifdef _WIN32
+	HANDLE m_console;
+	DWORD m_mode;
+	UINT m_codePage;
+#else
+	bool m_inputChanged;
+	termios m_inputSettings;
+#endif
+};
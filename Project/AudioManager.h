@@ -1,5 +1,10 @@
 #pragma once
+#ifdef _WIN32
 #include <windows.h>
+#else
+// there's no speaker to beep on outside Windows, the sounds are left out
+inline void Beep(unsigned int, unsigned int) {}
+#endif
 
 class AudioManager
 {
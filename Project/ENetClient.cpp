@@ -1,16 +1,28 @@
 #include "ENetClient.h"
+#include "ENetTiming.h"
+#include <algorithm>
 #include <chrono>
 #include <ctime>
 #include <thread>
 
 const uint8_t SERVER_ID = 0;
 const std::time_t REQUEST_INTERVAL = 16666; // 60fps
-
-char ENetClient::MESSAGE_BUFFER[] = {};
+// attempts in a row before giving up, and the delay after the first failed
+// one, which doubles up to the most
+const uint32_t CONNECT_ATTEMPTS = 8;
+const uint32_t FIRST_RETRY_DELAY_MS = 250;
+const uint32_t MAX_RETRY_DELAY_MS = 8000;
+// received messages kept for Poll() at most. Nothing polls in the menus,
+// the oldest data is thrown away there, it would be out of date anyway
+const size_t MAX_RECEIVED_MESSAGES = 256;
 
 ENetClient::ENetClient()
     : m_host(nullptr)
+    , m_server(nullptr)
     , m_peerID(-1)
+    , m_state(State::DISCONNECTED)
+    , m_failedAttempts(0)
+    , m_random(std::random_device()())
 {
     // initialize enet
     // TODO: prevent this from being called multiple times
@@ -43,62 +55,168 @@ ENetClient::~ENetClient()
 
 bool ENetClient::Connect(const std::string& host, uint32_t port)
 {
-    if (IsConnected()) 
+    if (m_state == State::CONNECTED || m_state == State::CONNECTING || m_state == State::RETRYING)
     {
         //LOG_DEBUG("ENetClient is already connected to a server");
         return 0;
     }
     // set address to connect to
-    ENetAddress address;
-    enet_address_set_host(&address, host.c_str());
-    address.port = port;
-    // initiate the connection, allocating the two channels 0 and 1.
-    m_server = enet_host_connect(m_host, &address, NUM_CHANNELS, 0);
-    if (m_server == nullptr) 
+    if (m_host == nullptr || enet_address_set_host(&m_address, host.c_str()) != 0)
     {
         return 1;
     }
-    // attempt to connect to the peer (server)
-    ENetEvent event;
-    // wait N for connection to succeed
+    m_address.port = static_cast<enet_uint16>(port);
+
+    m_failedAttempts = 0;
+    StartAttempt();
+    return 0;
+}
+
+void ENetClient::StartAttempt()
+{
+    // initiate the connection, allocating the two channels 0 and 1. The
+    // server answers through Update()
+    m_server = enet_host_connect(m_host, &m_address, NUM_CHANNELS, 0);
+    if (m_server == nullptr)
+    {
+        ScheduleRetry();
+        return;
+    }
+    m_state = State::CONNECTING;
+    m_attemptStart = Clock::now();
+}
+
+void ENetClient::ScheduleRetry()
+{
+    m_server = nullptr;
+    m_peerID = -1;
+    // whatever was queued for the old connection means nothing to a new one
+    m_sendQueue.Flush([](uint8_t, ENetPacket* packet) {
+        enet_packet_destroy(packet);
+    });
+
+    m_failedAttempts++;
+    if (m_failedAttempts >= CONNECT_ATTEMPTS)
+    {
+        m_state = State::FAILED;
+        return;
+    }
+
+    // up to a quarter more, so clients that lost the server together don't
+    // all come back on the same millisecond
+    uint32_t delay = std::min(FIRST_RETRY_DELAY_MS << (m_failedAttempts - 1), MAX_RETRY_DELAY_MS);
+    delay += m_random() % (delay / 4 + 1);
+    m_nextAttempt = Clock::now() + std::chrono::milliseconds(delay);
+    m_state = State::RETRYING;
+}
+
+void ENetClient::Update()
+{
+    if (m_state == State::RETRYING && Clock::now() >= m_nextAttempt)
+    {
+        StartAttempt();
+    }
+
+    if (m_state != State::CONNECTING)
+    {
+        if (m_state == State::CONNECTED)
+        {
+            Receive();
+        }
+        return;
+    }
+
     // NOTE: we don't need to check / destroy packets because the server will be
     // unable to send the packets without first establishing a connection
-    if (enet_host_service(m_host, &event, TIMEOUT_MS) > 0 && event.type == ENET_EVENT_TYPE_CONNECT) 
+    ENetEvent event;
+    while (m_state == State::CONNECTING && enet_host_service(m_host, &event, 0) > 0)
     {
-        if (event.peer != nullptr)
+        if (event.type == ENET_EVENT_TYPE_CONNECT)
         {
+            // Connection successful
             m_peerID = event.peer->outgoingPeerID;
+            m_state = State::CONNECTED;
+            m_failedAttempts = 0;
+            m_received.emplace_back(SERVER_ID, Message::Type::CONNECT);
         }
+        else if (event.type == ENET_EVENT_TYPE_DISCONNECT)
+        {
+            // refused, or ENet gave up on it
+            ScheduleRetry();
+        }
+        else if (event.type == ENET_EVENT_TYPE_RECEIVE)
+        {
+            enet_packet_destroy(event.packet);
+        }
+    }
 
-        // Connection successful
+    if (m_state == State::CONNECTING && Clock::now() - m_attemptStart > std::chrono::milliseconds(TIMEOUT_MS))
+    {
+        // failure to connect
+        enet_peer_reset(m_server);
+        ScheduleRetry();
+    }
 
-        return 0;
+    if (m_state == State::CONNECTED)
+    {
+        // whatever came along with the connection
+        Receive();
     }
-    // failure to connect
-     enet_peer_reset(m_server);
-    m_server = nullptr;
-    
-    return 1;
+}
+
+void ENetClient::SetBandwidthLimit(uint32_t incoming, uint32_t outgoing)
+{
+    if (m_host != nullptr)
+    {
+        enet_host_bandwidth_limit(m_host, incoming, outgoing);
+    }
+}
+
+bool ENetClient::SetCompression(PacketCompression::Type compression)
+{
+    return PacketCompression::Enable(m_host, compression);
 }
 
 bool ENetClient::Disconnect()
 {
+    if (m_state == State::CONNECTING)
+    {
+        // nothing to say goodbye to yet
+        enet_peer_reset(m_server);
+    }
     if (!IsConnected()) 
     {
+        m_server = nullptr;
+        m_peerID = -1;
+        m_state = State::DISCONNECTED;
+        m_received.clear();
         return 0;
     }
+    m_state = State::DISCONNECTED;
+    m_received.clear();
     
-    // attempt to gracefully disconnect
-    enet_peer_disconnect(m_server, 0);
+    // send whatever is still queued, then attempt to gracefully disconnect
+    // once it all went out
+    Flush();
+    enet_peer_disconnect_later(m_server, 0);
     // wait for the disconnect to be acknowledged
     ENetEvent event;
-    auto timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
-        std::chrono::system_clock::now().time_since_epoch())
-        .count();;
+    auto deadline = Clock::now() + std::chrono::milliseconds(TIMEOUT_MS);
     bool success = false;
-    while (true) 
+    while (!success) 
     {
-        int32_t res = enet_host_service(m_host, &event, 0);
+        auto now = Clock::now();
+        if (now >= deadline)
+        {
+            break;
+        }
+
+        // blocks on the socket, waking up when the disconnect or what was
+        // flushed before it is due to be resent. Rounded up, waking a
+        // little early would only spin until the deadline
+        auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(deadline - now).count();
+        uint32_t timeout = static_cast<uint32_t>(std::min<long long>((remaining + 999) / 1000, TIMEOUT_MS));
+        int32_t res = enet_host_service(m_host, &event, ENetTiming::GetServiceTimeout(m_host, timeout));
         if (res > 0) 
         {
             // event occured
@@ -111,7 +229,6 @@ bool ENetClient::Disconnect()
             {
                 // disconnect successful              
                 success = true;
-                break;
             }
         } 
         else if (res < 0) 
@@ -119,14 +236,6 @@ bool ENetClient::Disconnect()
             // error occured
             break;
         }
-        // check for timeout
-        auto now = std::chrono::duration_cast<std::chrono::microseconds>(
-            std::chrono::system_clock::now().time_since_epoch())
-            .count();
-        if (now - timestamp > TIMEOUT_MS * 1000) 
-        {
-            break;
-        }
     }
 
     if (!success) 
@@ -135,55 +244,101 @@ bool ENetClient::Disconnect()
         enet_peer_reset(m_server);
     }
     m_server = nullptr;
+    m_peerID = -1;
     return !success;
 }
 
+ENetSocket ENetClient::GetSocket() const
+{
+    return m_host != nullptr ? m_host->socket : ENET_SOCKET_NULL;
+}
+
 bool ENetClient::IsConnected() const
 {
-    return m_host->connectedPeers > 0;
+    return m_state == State::CONNECTED && m_host->connectedPeers > 0;
+}
+
+ENetClient::State ENetClient::GetState() const
+{
+    return m_state;
+}
+
+uint32_t ENetClient::GetRoundTripTime() const
+{
+    if (!IsConnected() || m_server == nullptr)
+    {
+        return 0;
+    }
+    return m_server->roundTripTime;
+}
+
+float ENetClient::GetPacketLoss() const
+{
+    if (!IsConnected() || m_server == nullptr)
+    {
+        return 0.0f;
+    }
+    // fixed point, scaled by ENET_PEER_PACKET_LOSS_SCALE
+    return static_cast<float>(m_server->packetLoss) / ENET_PEER_PACKET_LOSS_SCALE;
+}
+
+void ENetClient::Send(DeliveryType type, const std::string& messageStr)
+{
+    Send(type, reinterpret_cast<const uint8_t*>(messageStr.data()), messageStr.size());
 }
 
-void ENetClient::Send(DeliveryType type, const std::string& messageStr) const
+void ENetClient::Send(DeliveryType type, const uint8_t* data, size_t length)
 {
     if (!IsConnected())
     {
         return;
     }
 
-    uint32_t channel = 0;
-    uint32_t flags = 0;
-    if (type == DeliveryType::RELIABLE) 
-    {
-        channel = RELIABLE_CHANNEL;
-        flags = ENET_PACKET_FLAG_RELIABLE;
-    } 
-    else 
+    // queued until the next Flush(), batched with everything else sent
+    // during the frame
+    m_sendQueue.Queue(type, data, length);
+}
+
+uint8_t* ENetClient::BeginSend(DeliveryType type, size_t maxLength)
+{
+    if (!IsConnected())
     {
-        channel = UNRELIABLE_CHANNEL;
-        flags = ENET_PACKET_FLAG_UNSEQUENCED;
+        return nullptr;
     }
+    return m_sendQueue.Reserve(type, maxLength);
+}
 
-    // get bytes
+void ENetClient::CommitSend(size_t length)
+{
+    m_sendQueue.Commit(length);
+}
 
-    // create the packet
-    ENetPacket* p = enet_packet_create(
-        messageStr.c_str(),
-        strlen(messageStr.c_str()) + 1,
-        flags);
+void ENetClient::Flush()
+{
+    if (!IsConnected() || m_sendQueue.IsEmpty())
+    {
+        return;
+    }
 
-    // send the packet to the peer
-    enet_peer_send(m_server, channel, p);
+    ENetPeer* server = m_server;
+    m_sendQueue.Flush([server](uint8_t channel, ENetPacket* packet) {
+        // send the packet to the peer
+        enet_peer_send(server, channel, packet);
+    });
     // flush / send the packet queue
     enet_host_flush(m_host);
 }
 
 std::vector<Message> ENetClient::Poll()
 {
+    Update();
     std::vector<Message> msgs;
-    if (!IsConnected()) 
-    {
-        return msgs;
-    }
+    msgs.swap(m_received);
+    return msgs;
+}
+
+void ENetClient::Receive()
+{
     ENetEvent event;
     while (true) 
     {
@@ -194,37 +349,40 @@ std::vector<Message> ENetClient::Poll()
             // event occured
             if (event.type == ENET_EVENT_TYPE_RECEIVE) 
             {
-                // received a packet
-
-                memcpy(MESSAGE_BUFFER, event.packet->data, event.packet->dataLength);
-
-                Message msg = Message(SERVER_ID, Message::Type::DATA, MESSAGE_BUFFER);
-
-                msgs.push_back(msg);
-
-                // destroy packet payload
-                enet_packet_destroy(event.packet);
+                // received a batch, the messages in it take ownership of
+                // the packet so payloads are handed out without a copy
+                SendQueue::Unpack(SERVER_ID, event.packet, m_received);
 
             } 
             else if (event.type == ENET_EVENT_TYPE_DISCONNECT) 
             {
-                Message msg = Message(SERVER_ID, Message::Type::DISCONNECT, "");
-                msgs.push_back(msg);
-                m_server = nullptr;
+                m_received.emplace_back(SERVER_ID, Message::Type::DISCONNECT);
+                // connect again, the server forgot about us
+                m_failedAttempts = 0;
+                ScheduleRetry();
+                break;
             }
         } 
-        else if (res < 0) 
-        {
-            // error occured
-            
-            break;
-        } 
         else 
         {
-            // no event
+            // no event, or an error
             break;
         }
     }
-    
-    return msgs;
+
+    if (m_received.size() > MAX_RECEIVED_MESSAGES)
+    {
+        // connecting and disconnecting are kept, they change what the
+        // rest means
+        size_t excess = m_received.size() - MAX_RECEIVED_MESSAGES;
+        auto last = std::remove_if(m_received.begin(), m_received.end(), [&excess](const Message& message) {
+            if (excess > 0 && message.GetType() == Message::Type::DATA)
+            {
+                excess--;
+                return true;
+            }
+            return false;
+        });
+        m_received.erase(last, m_received.end());
+    }
 }
@@ -2,23 +2,68 @@
 
 #include "NetCommon.h"
 #include "Message.h"
+#include "PacketCompression.h"
+#include "SendQueue.h"
 
 #include <enet/enet.h>
 
+#include <chrono>
+#include <random>
+#include <string>
 #include <vector>
 
-
+// Connecting never blocks: Connect() only starts it, and Update() or Poll()
+// carry it on every frame. An attempt the server doesn't answer within
+// TIMEOUT_MS, or a connection that is lost, is retried after a delay that
+// doubles every time, until CONNECT_ATTEMPTS attempts in a row failed.
+// Poll() returns a CONNECT message once connected and a DISCONNECT one
+// when the connection is lost, a new connection starts over on the server.
+// Update() also takes in what the server sends, keeping it for Poll()
 class ENetClient 
 {
 public:
+    enum class State
+    {
+        // not connecting, before Connect() or after Disconnect()
+        DISCONNECTED,
+        CONNECTING,
+        CONNECTED,
+        // waiting to try again
+        RETRYING,
+        // gave up, until Connect() is called again
+        FAILED
+    };
+
     ENetClient();
     ~ENetClient();
 
+    // starts connecting, returns 1 if the address can't be used
     bool Connect(const std::string&, uint32_t);
+    // in bytes per second, 0 for any amount. Told to the server, which
+    // paces what it sends to the incoming limit; set before connecting so
+    // it applies from the start
+    void SetBandwidthLimit(uint32_t incoming, uint32_t outgoing);
+    // has to be the same the server uses, returns false if ENet couldn't
+    // set it up
+    bool SetCompression(PacketCompression::Type compression);
     bool Disconnect();
     bool IsConnected() const;
+    State GetState() const;
+    // carries on connecting and keeps what arrives for Poll(), once per
+    // frame while nothing calls Poll()
+    void Update();
 
-    void Send(DeliveryType, const std::string& messageStr) const;
+    // only queues the message, nothing goes out until Flush()
+    void Send(DeliveryType, const std::string& messageStr);
+    void Send(DeliveryType, const uint8_t* data, size_t length);
+
+    // encodes a message straight into the outgoing packet: write up to
+    // maxLength bytes to the returned buffer, then CommitSend() the length
+    // used. Returns nullptr while not connected
+    uint8_t* BeginSend(DeliveryType, size_t maxLength);
+    void CommitSend(size_t length);
+    // sends everything queued since the last flush, once per frame
+    void Flush();
     std::vector<Message> Poll();
 
     static ENetClient& GetInstance()
@@ -29,12 +74,39 @@ public:
 
     inline int GetPeerID() const { return m_peerID;  }
 
+    // everything from the server arrives on it, for waiting on it along
+    // with other things. ENET_SOCKET_NULL if the host couldn't be created
+    ENetSocket GetSocket() const;
+
+    // ENet's running estimates for the connection to the server, 0 while
+    // not connected
+    uint32_t GetRoundTripTime() const;
+    float GetPacketLoss() const;
+
 private:
-    
+    typedef std::chrono::steady_clock Clock;
+
+    void StartAttempt();
+    // after a failed attempt or a lost connection
+    void ScheduleRetry();
+    // takes in everything the server sent
+    void Receive();
+
     ENetHost* m_host;
     ENetPeer* m_server;
 
     int m_peerID;
 
-    static char MESSAGE_BUFFER[MAX_MESSAGE_LEN];
+    State m_state;
+    ENetAddress m_address;
+    // failed in a row, the delay before the next one doubles with each
+    uint32_t m_failedAttempts;
+    Clock::time_point m_attemptStart;
+    Clock::time_point m_nextAttempt;
+    // spreads the retries of clients that lost the server at once
+    std::minstd_rand m_random;
+    // what Poll() still has to hand out
+    std::vector<Message> m_received;
+
+    SendQueue m_sendQueue;
 };
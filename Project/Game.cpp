@@ -1,11 +1,102 @@
 #include "Game.h"
-#include <thread>
 #include <chrono>
 
 #include "ENetClient.h"
+#include "KeyboardInput.h"
+#include "Renderer.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <poll.h>
+#include <thread>
+#endif
 
 const std::string HOST = "localhost";
 const uint32_t PORT = 7000;
+// has to match the server's --compression
+const PacketCompression::Type COMPRESSION = PacketCompression::Type::NONE;
+
+typedef std::chrono::steady_clock Clock;
+
+// sleeps until a key is pressed, something arrives from the server or the
+// deadline passes. Returns true if a key is waiting
+#ifdef _WIN32
+static bool WaitForEvents(WSAEVENT socketEvent, Clock::time_point deadline)
+{
+	KeyboardInput& keyboard = KeyboardInput::GetInstance();
+	HANDLE handles[] = { keyboard.GetKeyEvent(), socketEvent };
+	DWORD handleCount = socketEvent != WSA_INVALID_EVENT ? 2 : 1;
+	while (!keyboard.HasKeys())
+	{
+		auto now = Clock::now();
+		if (now >= deadline)
+		{
+			return false;
+		}
+
+		DWORD timeout = static_cast<DWORD>(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count() + 1);
+		DWORD result = WaitForMultipleObjects(handleCount, handles, FALSE, timeout);
+		if (result == WAIT_OBJECT_0 + 1)
+		{
+			// stays signalled until reset, and is signalled again once
+			// ENet reads from the socket and leaves something behind
+			WSAResetEvent(socketEvent);
+			return keyboard.HasKeys();
+		}
+		if (result == WAIT_FAILED)
+		{
+			// can't wait on them, at least don't spin
+			Sleep(timeout);
+			return keyboard.HasKeys();
+		}
+		// a key, which may have been taken already when the event was
+		// still signalled from before, or the deadline
+	}
+	return true;
+}
+#else
+static bool WaitForEvents(ENetSocket socket, Clock::time_point deadline)
+{
+	KeyboardInput& keyboard = KeyboardInput::GetInstance();
+	pollfd fds[2] = {};
+	fds[0].fd = keyboard.GetKeyFd();
+	fds[0].events = POLLIN;
+	fds[1].fd = socket;
+	fds[1].events = POLLIN;
+	nfds_t fdCount = socket != ENET_SOCKET_NULL ? 2 : 1;
+	while (!keyboard.HasKeys())
+	{
+		auto now = Clock::now();
+		if (now >= deadline)
+		{
+			return false;
+		}
+
+		int timeout = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count() + 1);
+		int result = poll(fds, fdCount, timeout);
+		if (result < 0 && errno != EINTR)
+		{
+			// can't wait on them, at least don't spin
+			std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+			return keyboard.HasKeys();
+		}
+		if (result > 0 && fds[0].revents != 0)
+		{
+			// emptied before looking at the keys, so one queued after
+			// that signals again
+			keyboard.ClearKeySignal();
+		}
+		if (result > 0 && fdCount > 1 && fds[1].revents != 0)
+		{
+			// readable until ENet reads it, which the update after this does
+			return keyboard.HasKeys();
+		}
+	}
+	return true;
+}
+#endif
 
 Game::Game()
 	: m_pStateMachine(nullptr)
@@ -26,21 +117,75 @@ void Game::RunGameLoop()
 {
 	bool isGameOver = false;
 
+	// only starts connecting, the menu shows right away
+	ENetClient::GetInstance().SetCompression(COMPRESSION);
 	ENetClient::GetInstance().Connect(HOST, PORT);
 
-	while (!isGameOver)
+	// the screen is the game's until the loop ends, then keys are read on
+	// a thread of their own
+	m_pTerminal = Terminal::Create();
+	Renderer::GetInstance().SetTerminal(m_pTerminal.get());
+	KeyboardInput::GetInstance().Start();
+
+	// the loop wakes up for the server as well as for the keyboard
+	ENetSocket socket = ENetClient::GetInstance().GetSocket();
+#ifdef _WIN32
+	// signalled whenever a datagram arrives on ENet's socket
+	WSAEVENT socketEvent = WSA_INVALID_EVENT;
+	if (socket != ENET_SOCKET_NULL)
 	{
-		// update with no input
-		Update(false);
-		// Draw
-		Draw();
-		// Update with input
-		isGameOver = Update();
-
-		std::this_thread::sleep_for(std::chrono::milliseconds(33)); // 30 fps
+		socketEvent = WSACreateEvent();
+		if (socketEvent != WSA_INVALID_EVENT && WSAEventSelect(socket, socketEvent, FD_READ) != 0)
+		{
+			WSACloseEvent(socketEvent);
+			socketEvent = WSA_INVALID_EVENT;
+		}
 	}
+#endif
 
+	Update(false);
 	Draw();
+	Clock::time_point nextUpdate = Clock::now();
+	while (!isGameOver)
+	{
+		// nothing happens between a key, the server and what the state
+		// wants done every so often, so there's nothing to do until one
+		// of them comes along
+#ifdef _WIN32
+		bool keyPressed = WaitForEvents(socketEvent, nextUpdate);
+#else
+		bool keyPressed = WaitForEvents(socket, nextUpdate);
+#endif
+
+		// a key is handled the moment it's pressed, along with whatever
+		// arrived from the server
+		isGameOver = Update(keyPressed);
+		// Carry on connecting, then send everything the update queued in one go
+		ENetClient::GetInstance().Update();
+		ENetClient::GetInstance().Flush();
+		nextUpdate = Clock::now() + std::chrono::milliseconds(m_pStateMachine->GetUpdateIntervalMs());
+
+		// a frame where nothing changed isn't drawn again
+		if (keyPressed || m_pStateMachine->NeedsRedraw())
+		{
+			Draw();
+		}
+	}
+
+#ifdef _WIN32
+	if (socketEvent != WSA_INVALID_EVENT)
+	{
+		// the socket goes back to how ENet had it
+		WSAEventSelect(socket, socketEvent, 0);
+		WSACloseEvent(socketEvent);
+	}
+#endif
+	KeyboardInput::GetInstance().Stop();
+
+	// back to what was on the screen before the game
+	Renderer::GetInstance().SetTerminal(nullptr);
+	m_pTerminal->Stop();
+	m_pTerminal.reset();
 }
 
 void Game::Deinitialize()
@@ -56,5 +201,8 @@ bool Game::Update(bool processInput)
 
 void Game::Draw()
 {
+	// the state draws a whole frame, only what changed reaches the console
+	Renderer::GetInstance().BeginFrame();
 	m_pStateMachine->DrawCurrentState();
+	Renderer::GetInstance().Present();
 }
@@ -2,10 +2,14 @@
 #include "GameStateMachine.h"
 #include "Player.h"
 #include "Level.h"
+#include "Terminal.h"
+
+#include <memory>
 
 class Game
 {
 	GameStateMachine* m_pStateMachine;
+	std::unique_ptr<Terminal> m_pTerminal;
 public:
 	Game();
 	void Initialize(GameStateMachine* pStateMachine);
@@ -3,10 +3,21 @@
 class GameState
 {
 public:
+	// how long a state that doesn't say otherwise can go without an Update()
+	// while no key is pressed and nothing arrives from the server
+	static constexpr int kIdleUpdateMs = 250;
+
 	virtual ~GameState() {}
 
 	virtual void Enter() {}
+	// processInput is true while KeyboardInput has keys queued
 	virtual bool Update(bool processInput = true) { return false; }
 	virtual void Draw() = 0;
 	virtual void Exit() {}
-};
\ No newline at end of file
+
+	// longest the state can wait for its next Update() when nothing happens
+	virtual int GetUpdateIntervalMs() const { return kIdleUpdateMs; }
+	// true if Draw() would show something new without a key being pressed,
+	// a key always draws the state again
+	virtual bool NeedsRedraw() const { return false; }
+};
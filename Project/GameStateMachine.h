@@ -10,6 +10,10 @@ public:
 	virtual bool Init() = 0;
 	virtual bool UpdateCurrentState(bool processInput = true) = 0;
 	virtual void DrawCurrentState() = 0;
+	virtual int GetUpdateIntervalMs() const = 0;
+	// true if the current state changed since it was last drawn, or has
+	// something new to show
+	virtual bool NeedsRedraw() const = 0;
 	virtual void ChangeState(GameState* pNewState) = 0;
 	virtual bool Cleanup() = 0;
 };
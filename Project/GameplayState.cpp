@@ -1,10 +1,8 @@
 #include "GameplayState.h"
 
 #include <iostream>
-#include <conio.h>
-#include <windows.h>
 #include <assert.h>
-#include <sstream>
+#include <set>
 
 #include "Enemy.h"
 #include "Key.h"
@@ -12,6 +10,9 @@
 #include "Money.h"
 #include "Goal.h"
 #include "AudioManager.h"
+#include "KeyboardInput.h"
+#include "LevelView.h"
+#include "Renderer.h"
 #include "Utility.h"
 #include "StateMachineExampleGame.h"
 
@@ -23,6 +24,11 @@ constexpr int kRightArrow = 77;
 constexpr int kUpArrow = 72;
 constexpr int kDownArrow = 80;
 constexpr int kEscapeKey = 27;
+// inputs go out unreliably, the ones not acknowledged yet are sent again
+// this often until a snapshot acknowledges them
+constexpr int kInputResendMs = 50;
+// how often everyone else is moved on while they are shown, 30 fps
+constexpr int kFrameMs = 33;
 
 GameplayState::GameplayState(StateMachineExampleGame* pOwner)
 	: m_pOwner(pOwner)
@@ -31,16 +37,11 @@ GameplayState::GameplayState(StateMachineExampleGame* pOwner)
 	, m_currentLevel(0)
 	, m_pLevel(nullptr)
 	, m_player(true)
+	, m_redraw(true)
 {
 	m_LevelNames.push_back("Level1.txt");
 	m_LevelNames.push_back("Level2.txt");
 	m_LevelNames.push_back("Level3.txt");
-
-	auto getInput = []()->int {
-		return _getch();
-	};
-
-	m_inputFuture = std::async(std::launch::async, getInput);
 }
 
 GameplayState::~GameplayState()
@@ -71,7 +72,14 @@ bool GameplayState::Load()
 
 	m_pLevel = new Level();
 	
-	return m_pLevel->Load(m_LevelNames.at(m_currentLevel), m_player.GetXPositionPointer(), m_player.GetYPositionPointer());
+	bool loaded = m_pLevel->Load("../" + m_LevelNames.at(m_currentLevel), m_player.GetXPositionPointer(), m_player.GetYPositionPointer());
+	m_levelWarnings = m_pLevel->GetWarnings();
+
+	// only players on the same level are shown
+	JoinRoom(static_cast<uint32_t>(m_currentLevel));
+	m_redraw = true;
+
+	return loaded;
 
 }
 
@@ -83,75 +91,98 @@ void GameplayState::Enter()
 bool GameplayState::Update(bool processInput)
 {
 	
-	if (processInput && !m_beatLevel)
+	if (!m_beatLevel)
 	{
 		ProcessENetMessages();
-		
+		ShowOtherPlayers();
 
-		// sends _getch to a different thread and only process input when a key is pressed
-		if (m_inputFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
-			auto input = m_inputFuture.get();
-
-			auto getInput = []()->int {
-				return _getch();
-			};
+		if (m_predictor.GetPendingCount() > 0 &&
+			std::chrono::steady_clock::now() - m_lastInputSent >= std::chrono::milliseconds(kInputResendMs))
+		{
+			SendPendingInputs();
+		}
+	}
 
-			m_inputFuture = std::async(std::launch::async, getInput);					
+	KeyEvent key;
+	// the level's warnings are shown until a key is pressed, which only
+	// puts them away
+	if (!m_levelWarnings.empty())
+	{
+		if (processInput && KeyboardInput::GetInstance().Pop(key))
+		{
+			m_levelWarnings.clear();
+			m_redraw = true;
+		}
+		return false;
+	}
 
-			int arrowInput = 0;
-			int newPlayerX = m_player.GetXPosition();
-			int newPlayerY = m_player.GetYPosition();
+	// every key pressed since the last update, until one of them ends the
+	// level or leaves it, the rest are for what comes next
+	while (processInput && !m_beatLevel && !m_pOwner->IsChangingScene() && KeyboardInput::GetInstance().Pop(key))
+	{
+		int input = key.key;
+		int arrowInput = key.extendedKey;
+		int newPlayerX = m_player.GetXPosition();
+		int newPlayerY = m_player.GetYPosition();
+		Protocol::Direction direction = Protocol::Direction::LEFT;
 
-			// One of the arrow keys were pressed
-			
-			if ((input == kArrowInput && arrowInput == kLeftArrow) ||
-				(char)input == 'A' || (char)input == 'a')
-			{
-				newPlayerX--;
-			}
-			else if ((input == kArrowInput && arrowInput == kRightArrow) ||
-				(char)input == 'D' || (char)input == 'd')
-			{
-				newPlayerX++;
-			}
-			else if ((input == kArrowInput && arrowInput == kUpArrow) ||
-				(char)input == 'W' || (char)input == 'w')
-			{
-				newPlayerY--;
-			}
-			else if ((input == kArrowInput && arrowInput == kDownArrow) ||
-				(char)input == 'S' || (char)input == 's')
-			{
-				newPlayerY++;
-			}
-			else if (input == kEscapeKey)
-			{
-				m_pOwner->LoadScene(StateMachineExampleGame::SceneName::MainMenu);
-			}
-			else if ((char)input == 'Z' || (char)input == 'z')
+		// One of the arrow keys were pressed
+		
+		if ((input == kArrowInput && arrowInput == kLeftArrow) ||
+			(char)input == 'A' || (char)input == 'a')
+		{
+			newPlayerX--;
+			direction = Protocol::Direction::LEFT;
+		}
+		else if ((input == kArrowInput && arrowInput == kRightArrow) ||
+			(char)input == 'D' || (char)input == 'd')
+		{
+			newPlayerX++;
+			direction = Protocol::Direction::RIGHT;
+		}
+		else if ((input == kArrowInput && arrowInput == kUpArrow) ||
+			(char)input == 'W' || (char)input == 'w')
+		{
+			newPlayerY--;
+			direction = Protocol::Direction::UP;
+		}
+		else if ((input == kArrowInput && arrowInput == kDownArrow) ||
+			(char)input == 'S' || (char)input == 's')
+		{
+			newPlayerY++;
+			direction = Protocol::Direction::DOWN;
+		}
+		else if (input == kEscapeKey)
+		{
+			m_pOwner->LoadScene(StateMachineExampleGame::SceneName::MainMenu);
+		}
+		else if ((char)input == 'Z' || (char)input == 'z')
+		{
+			if (m_player.HasKey())
 			{
+				AudioManager::GetInstance()->PlayKeyDropSound();
 				m_player.DropKey();
 			}
+		}
 
-			// If position never changed
-			if (newPlayerX == m_player.GetXPosition() && newPlayerY == m_player.GetYPosition())
-			{
-				//return false;
-			}
-			else
+		// If position never changed
+		if (newPlayerX == m_player.GetXPosition() && newPlayerY == m_player.GetYPosition())
+		{
+			//return false;
+		}
+		else
+		{
+			int oldPlayerX = m_player.GetXPosition();
+			int oldPlayerY = m_player.GetYPosition();
+			HandleCollision(newPlayerX, newPlayerY);
+
+			// the server only hears about steps the game let us take,
+			// so doors and pickups stay the game's business
+			if (m_player.GetXPosition() != oldPlayerX || m_player.GetYPosition() != oldPlayerY)
 			{
-				HandleCollision(newPlayerX, newPlayerY);
+				SendInput(direction);
 			}
-
-			// Boradcasts current position to other players
-			std::stringstream stringStream;
-
-			stringStream << ENetClient::GetInstance().GetPeerID() << "-" << m_player.GetXPosition() << "," << m_player.GetYPosition();
-
-			ENetClient::GetInstance().Send(DeliveryType::RELIABLE, stringStream.str());
 		}
-		
-		
 	}
 	if (m_beatLevel)
 	{
@@ -276,19 +307,64 @@ void GameplayState::HandleCollision(int newPlayerX, int newPlayerY)
 	}
 }
 
+void GameplayState::SendInput(Protocol::Direction direction)
+{
+	m_predictor.Push(direction);
+	SendPendingInputs();
+}
+
+void GameplayState::SendPendingInputs()
+{
+	// every step the server hasn't acknowledged yet goes along, so a lost
+	// packet is covered by the next one instead of holding up the rest
+	// behind a resend like on the reliable channel
+	Protocol::Input inputs[Protocol::MAX_INPUTS_PER_MESSAGE];
+	size_t count = m_predictor.GetPending(inputs, Protocol::MAX_INPUTS_PER_MESSAGE);
+
+	// encoded straight into the outgoing packet
+	uint8_t* buffer = ENetClient::GetInstance().BeginSend(DeliveryType::UNRELIABLE, Protocol::GetMaxInputSize());
+	if (buffer != nullptr)
+	{
+		ENetClient::GetInstance().CommitSend(Protocol::EncodeInputs(inputs, count, buffer, Protocol::GetMaxInputSize()));
+	}
+	m_lastInputSent = std::chrono::steady_clock::now();
+}
+
+int GameplayState::GetUpdateIntervalMs() const
+{
+	// the others move between snapshots and the level change waits a few
+	// frames, the inputs not acknowledged yet go out again now and then.
+	// Otherwise nothing happens until a key is pressed or the server sends
+	// something
+	if (m_beatLevel || !m_otherPlayers.empty())
+	{
+		return kFrameMs;
+	}
+	if (m_predictor.GetPendingCount() > 0)
+	{
+		return kInputResendMs;
+	}
+	return kIdleUpdateMs;
+}
+
+bool GameplayState::NeedsRedraw() const
+{
+	return m_redraw;
+}
+
 void GameplayState::Draw()
 {
-	HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
-	system("cls");
+	m_redraw = false;
 
-	m_pLevel->Draw();
+	if (!m_levelWarnings.empty())
+	{
+		DrawLevelWarnings();
+		return;
+	}
 
-	// Set cursor position for player 
-	COORD actorCursorPosition;
-	actorCursorPosition.X = m_player.GetXPosition();
-	actorCursorPosition.Y = m_player.GetYPosition();
-	SetConsoleCursorPosition(console, actorCursorPosition);
-	m_player.Draw();
+	LevelView::Draw(*m_pLevel);
+
+	LevelView::DrawActor(m_player, m_player.GetXPosition(), m_player.GetYPosition());
 
 	for (const auto& otherPlayerPair : m_otherPlayers)
 	{
@@ -296,70 +372,60 @@ void GameplayState::Draw()
 
 		if (otherPlayer != nullptr)
 		{
-			COORD cursorPosition;
-			cursorPosition.X = otherPlayer->GetXPosition();
-			cursorPosition.Y = otherPlayer->GetYPosition();
-			SetConsoleCursorPosition(console, cursorPosition);
-			otherPlayer->Draw();
+			LevelView::DrawActor(*otherPlayer, otherPlayer->GetXPosition(), otherPlayer->GetYPosition());
 		}
 		
 	}
 
-	// Set the cursor to the end of the level
-	COORD currentCursorPosition;
-	currentCursorPosition.X = 0;
-	currentCursorPosition.Y = m_pLevel->GetHeight();
-	SetConsoleCursorPosition(console, currentCursorPosition);
-
-	DrawHUD(console);
+	// below the level, after an empty line
+	DrawHUD(m_pLevel->GetHeight() + 1);
 }
 
-void GameplayState::DrawHUD(const HANDLE& console)
+void GameplayState::DrawLevelWarnings()
 {
-	cout << endl;
+	Renderer& renderer = Renderer::GetInstance();
 
-	// Top Border
-	for (int i = 0; i < m_pLevel->GetWidth(); ++i)
+	int y = 0;
+	for (const std::string& warning : m_levelWarnings)
 	{
-		cout << Level::WAL;
+		renderer.DrawText(0, y++, warning);
 	}
-	cout << endl;
+	renderer.DrawText(0, y + 1, "There were some warnings in the level data, see above.");
+	renderer.DrawText(0, y + 2, "Press any key to continue");
+}
 
-	// Left Side border
-	cout << Level::WAL;
+void GameplayState::DrawHUD(int top)
+{
+	Renderer& renderer = Renderer::GetInstance();
+	std::string border(m_pLevel->GetWidth(), Level::WAL);
 
-	cout << " wasd-move " << Level::WAL << " z-drop key " << Level::WAL;
+	// Top Border
+	renderer.DrawText(0, top, border);
 
-	cout << " $:" << m_player.GetMoney() << " " << Level::WAL;
-	cout << " lives:" << m_player.GetLives() << " " << Level::WAL;
-	cout << " key:";
+	// Left Side border
+	int x = 0;
+	renderer.Draw(x++, top + 1, Level::WAL);
+
+	x = renderer.DrawText(x, top + 1, " wasd-move ");
+	renderer.Draw(x++, top + 1, Level::WAL);
+	x = renderer.DrawText(x, top + 1, " z-drop key ");
+	renderer.Draw(x++, top + 1, Level::WAL);
+
+	x = renderer.DrawText(x, top + 1, " $:" + std::to_string(m_player.GetMoney()) + " ");
+	renderer.Draw(x++, top + 1, Level::WAL);
+	x = renderer.DrawText(x, top + 1, " lives:" + std::to_string(m_player.GetLives()) + " ");
+	renderer.Draw(x++, top + 1, Level::WAL);
+	x = renderer.DrawText(x, top + 1, " key:");
 	if (m_player.HasKey())
 	{
-		m_player.GetKey()->Draw();
-	}
-	else
-	{
-		cout << " ";
+		LevelView::DrawActor(*m_player.GetKey(), x, top + 1);
 	}
 
 	// RightSide border
-	CONSOLE_SCREEN_BUFFER_INFO csbi;
-	GetConsoleScreenBufferInfo(console, &csbi);
-
-	COORD pos;
-	pos.X = m_pLevel->GetWidth() - 1;
-	pos.Y = csbi.dwCursorPosition.Y;
-	SetConsoleCursorPosition(console, pos);
-
-	cout << Level::WAL;
-	cout << endl;
+	renderer.Draw(m_pLevel->GetWidth() - 1, top + 1, Level::WAL);
 
 	// Bottom Border
-	for (int i = 0; i < m_pLevel->GetWidth(); ++i)
-	{
-		cout << Level::WAL;
-	}
-	cout << endl;
+	renderer.DrawText(0, top + 2, border);
 }
 
 void GameplayState::ProcessENetMessages()
@@ -370,47 +436,133 @@ void GameplayState::ProcessENetMessages()
 	// process messages
 	for (const auto& msg : messages)
 	{
-		int id = msg.GetPeerID();
-
 		switch (msg.GetType())
 		{
+			case Message::Type::CONNECT:
+
+				// connected in the background, or again after losing the
+				// server, which doesn't know which room we are in yet and
+				// puts us at its spawn
+				JoinRoom(static_cast<uint32_t>(m_currentLevel));
+				break;
+
 			case Message::Type::DISCONNECT:
 
-				// TODO: handle the disconnect
+				// the client connects again by itself, and a new connection
+				// starts the snapshot sequence over
+				m_snapshots.Reset(m_snapshots.GetRoomID());
+				m_interpolation.Reset();
 				break;
 
 			case Message::Type::DATA:
+			{
+				// the server sends at most one snapshot per tick, as a delta
+				// against the last one we acknowledged
+				if (!m_snapshots.Receive(msg.GetData(), msg.GetDataLength()))
+				{
+					break;
+				}
+
+				uint8_t* buffer = ENetClient::GetInstance().BeginSend(DeliveryType::UNRELIABLE, Protocol::GetMaxSnapshotAckSize());
+				if (buffer != nullptr)
+				{
+					ENetClient::GetInstance().CommitSend(Protocol::EncodeSnapshotAck(m_snapshots.GetLastSequence(), buffer, Protocol::GetMaxSnapshotAckSize()));
+				}
 
-				std::string dataStr = msg.GetData();
+				Reconcile(m_snapshots.GetSnapshot());
+				m_interpolation.Add(m_snapshots.GetSnapshot(), InterpolationBuffer::Clock::now());
+				break;
+			}
+		}
+	}
+}
 
-				//split string
-				const auto dataPrefixPos = dataStr.find("-");
+void GameplayState::JoinRoom(uint32_t roomId)
+{
+	// the players of the previous room are gone, and the new room numbers
+	// its snapshots from the start. Joining the room we are in again only
+	// sends us back to its spawn
+	if (roomId != m_snapshots.GetRoomID())
+	{
+		for (auto& otherPlayer : m_otherPlayers)
+		{
+			delete otherPlayer.second;
+		}
+		m_otherPlayers.clear();
+		m_snapshots.Reset(roomId);
+		m_interpolation.Reset();
+	}
 
-				std::string peerIDStr = dataStr.substr(0, dataPrefixPos);
-				int peerID = atoi(peerIDStr.c_str());
+	// steps taken before the join don't count anymore
+	uint32_t joinSequence = m_predictor.Restart();
 
-				if (peerID != ENetClient::GetInstance().GetPeerID())
-				{
-					if (m_otherPlayers.count(id) == 0)
-					{
-						Player* otherPlayer = new Player(false);
-						m_otherPlayers[id] = otherPlayer;
-					}
+	uint8_t* buffer = ENetClient::GetInstance().BeginSend(DeliveryType::RELIABLE, Protocol::GetMaxJoinSize());
+	if (buffer != nullptr)
+	{
+		ENetClient::GetInstance().CommitSend(Protocol::EncodeJoin(roomId, joinSequence, buffer, Protocol::GetMaxJoinSize()));
+	}
+}
 
-					Player* otherPlayer = m_otherPlayers.at(id);
+void GameplayState::Reconcile(const Protocol::Snapshot& snapshot)
+{
+	// where the server has us, with the steps it hasn't seen yet replayed
+	// on top. Normally that is where we already are
+	int x = 0;
+	int y = 0;
+	auto isWall = [this](int tileX, int tileY) { return m_pLevel->IsWall(tileX, tileY); };
+	if (m_predictor.Reconcile(snapshot, isWall, x, y))
+	{
+		m_player.SetPosition(x, y);
+		m_redraw = true;
+	}
+}
 
-					std::string positionStr = dataStr.substr(dataPrefixPos + 1, dataStr.size() - peerIDStr.size() - 1);
+void GameplayState::ShowOtherPlayers()
+{
+	// players are only moved ahead onto tiles of the level that aren't walls
+	auto isWall = [this](int tileX, int tileY) {
+		return tileX < 0 || tileY < 0 || tileX >= m_pLevel->GetWidth() || tileY >= m_pLevel->GetHeight()
+			|| m_pLevel->IsWall(tileX, tileY);
+	};
+	m_interpolation.Sample(InterpolationBuffer::Clock::now(), isWall, m_shownPlayers);
 
-					const auto findPos = positionStr.find(",");
+	std::set<int> playersShown;
+	for (const auto& position : m_shownPlayers)
+	{
+		int peerID = static_cast<int>(position.peerId);
+		if (peerID == ENetClient::GetInstance().GetPeerID())
+		{
+			continue;
+		}
 
-					std::string strX = positionStr.substr(0, findPos);
-					std::string strY = positionStr.substr(findPos + 1, positionStr.size() - strX.size() - 1);
+		if (m_otherPlayers.count(peerID) == 0)
+		{
+			Player* otherPlayer = new Player(false);
+			m_otherPlayers[peerID] = otherPlayer;
+			m_redraw = true;
+		}
 
-					otherPlayer->SetPosition(atoi(strX.c_str()), atoi(strY.c_str()));
-				}
-							
+		Player* otherPlayer = m_otherPlayers.at(peerID);
+		if (otherPlayer->GetXPosition() != position.x || otherPlayer->GetYPosition() != position.y)
+		{
+			otherPlayer->SetPosition(position.x, position.y);
+			m_redraw = true;
+		}
+		playersShown.insert(peerID);
+	}
 
-			break;
+	// players that left, or aren't there yet at the time shown
+	for (auto iter = m_otherPlayers.begin(); iter != m_otherPlayers.end();)
+	{
+		if (playersShown.count(iter->first) == 0)
+		{
+			delete iter->second;
+			iter = m_otherPlayers.erase(iter);
+			m_redraw = true;
+		}
+		else
+		{
+			++iter;
 		}
 	}
 }
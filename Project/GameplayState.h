@@ -4,14 +4,17 @@
 #include "Level.h"
 
 #include "ENetClient.h"
+#include "InterpolationBuffer.h"
+#include "MovePredictor.h"
+#include "Protocol.h"
+#include "SnapshotReceiver.h"
 
-#include <windows.h>
 #include <vector>
 #include <string>
 
 #include <map>
 
-#include <future>
+#include <chrono>
 
 class StateMachineExampleGame;
 
@@ -28,6 +31,13 @@ class GameplayState : public GameState
 
 	int m_currentLevel;
 
+	// something changed that isn't down to a key
+	bool m_redraw;
+
+	// what was wrong with the level file, shown instead of the level until
+	// a key is pressed
+	std::vector<std::string> m_levelWarnings;
+
 	std::vector<std::string> m_LevelNames;
 
 public:
@@ -37,15 +47,36 @@ public:
 	virtual void Enter() override;
 	virtual bool Update(bool processInput = true) override;
 	virtual void Draw() override;
+	virtual int GetUpdateIntervalMs() const override;
+	virtual bool NeedsRedraw() const override;
 
 private:
 	void HandleCollision(int newPlayerX, int newPlayerY);
+	void SendInput(Protocol::Direction direction);
+	void SendPendingInputs();
 	bool Load();
-	void DrawHUD(const HANDLE& console);
+	void DrawLevelWarnings();
+	// takes up 3 lines, starting at top
+	void DrawHUD(int top);
 
 	void ProcessENetMessages();
 
-	std::future<int> m_inputFuture;
-
 	std::map<int, Player*> m_otherPlayers;
+
+	void JoinRoom(uint32_t roomId);
+	void ShowOtherPlayers();
+	void Reconcile(const Protocol::Snapshot& snapshot);
+
+	// snapshots of the room we are in, every level is its own room on
+	// the server
+	SnapshotReceiver m_snapshots;
+
+	// our own moves show at once, the server corrects them afterwards
+	MovePredictor m_predictor;
+	std::chrono::steady_clock::time_point m_lastInputSent;
+
+	// everyone else is shown a little in the past, moving smoothly between
+	// the snapshots around that time
+	InterpolationBuffer m_interpolation;
+	std::vector<Protocol::PlayerPosition> m_shownPlayers;
 };
@@ -1,13 +1,10 @@
 #include "HighScoreState.h"
 
-#include <iostream>
-#include <conio.h>
-
+#include "KeyboardInput.h"
+#include "Renderer.h"
 #include "StateMachineExampleGame.h"
 #include "Utility.h"
 
-using namespace std;
-
 
 HighScoreState::HighScoreState(StateMachineExampleGame* pOwner)
 	: m_pOwner(pOwner)
@@ -17,9 +14,9 @@ HighScoreState::HighScoreState(StateMachineExampleGame* pOwner)
 
 bool HighScoreState::Update(bool processInput)
 {
-	if (processInput)
+	KeyEvent key;
+	if (processInput && KeyboardInput::GetInstance().Pop(key))
 	{
-		int input = _getch();
 		m_pOwner->LoadScene(StateMachineExampleGame::SceneName::MainMenu);
 	}
 	return false;
@@ -27,16 +24,14 @@ bool HighScoreState::Update(bool processInput)
 
 void HighScoreState::Draw()
 {
-	system("cls");
-	cout << endl << endl << endl;
-	cout << "          - - - HIGH SCORES - - -" << endl << endl;
+	Renderer& renderer = Renderer::GetInstance();
+	renderer.DrawText(10, 3, "- - - HIGH SCORES - - -");
 
+	int y = 5;
 	for (auto i = m_HighScores.rbegin(); i != m_HighScores.rend(); ++i)
 	{
-		cout << "             " << *i << endl;
+		renderer.DrawText(13, y++, std::to_string(*i));
 	}
 
-	cout << endl << endl;
-	cout << "             Press any key to go back to the main menu" << endl << endl << endl;
-
+	renderer.DrawText(13, y + 2, "Press any key to go back to the main menu");
 }
\ No newline at end of file
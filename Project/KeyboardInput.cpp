@@ -0,0 +1,352 @@
+#include "KeyboardInput.h"
+
+#ifdef _WIN32
+#include <conio.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+// keys pressed the game hasn't got to yet, far more than a burst of
+// typing or a bot sends between two updates
+constexpr size_t kKeyQueueSize = 256;
+
+// what _getch() returns in front of arrow keys and the like
+constexpr int kExtendedKey = 224;
+
+#ifdef _WIN32
+// true for a key press _getch() returns, it skips releases, modifiers on
+// their own and anything that isn't a key
+static bool IsKeyPress(const INPUT_RECORD& record)
+{
+	if (record.EventType != KEY_EVENT || !record.Event.KeyEvent.bKeyDown)
+	{
+		return false;
+	}
+	if (record.Event.KeyEvent.uChar.UnicodeChar != 0)
+	{
+		return true;
+	}
+	switch (record.Event.KeyEvent.wVirtualKeyCode)
+	{
+	case VK_SHIFT:
+	case VK_CONTROL:
+	case VK_MENU:
+	case VK_CAPITAL:
+	case VK_NUMLOCK:
+	case VK_SCROLL:
+	case VK_LWIN:
+	case VK_RWIN:
+		return false;
+	default:
+		// arrows and the like, which _getch() returns as two codes
+		return true;
+	}
+}
+
+// true if _getch() wouldn't block. Whatever is in front of the first key
+// press is thrown away, _kbhit() looks past it and it would keep the
+// console input signalled
+static bool IsKeyWaiting(HANDLE input)
+{
+	INPUT_RECORD record;
+	DWORD count = 0;
+	while (PeekConsoleInputW(input, &record, 1, &count) && count > 0 && !IsKeyPress(record))
+	{
+		ReadConsoleInputW(input, &record, 1, &count);
+	}
+	if (_kbhit())
+	{
+		return true;
+	}
+	// a key _getch() doesn't know either
+	if (count > 0)
+	{
+		ReadConsoleInputW(input, &record, 1, &count);
+	}
+	return false;
+}
+
+KeyboardInput::KeyboardInput()
+	: m_input(GetStdHandle(STD_INPUT_HANDLE))
+	, m_keyEvent(CreateEventA(nullptr, FALSE, FALSE, nullptr))
+	, m_stopEvent(CreateEventA(nullptr, TRUE, FALSE, nullptr))
+	, m_keys(kKeyQueueSize)
+{
+}
+
+KeyboardInput::~KeyboardInput()
+{
+	Stop();
+	CloseHandle(m_keyEvent);
+	CloseHandle(m_stopEvent);
+}
+
+bool KeyboardInput::Start()
+{
+	if (m_thread.joinable())
+	{
+		return true;
+	}
+	if (m_keyEvent == nullptr || m_stopEvent == nullptr)
+	{
+		return false;
+	}
+
+	ResetEvent(m_stopEvent);
+	m_thread = std::thread(&KeyboardInput::Run, this);
+	return true;
+}
+
+void KeyboardInput::Stop()
+{
+	if (!m_thread.joinable())
+	{
+		return;
+	}
+
+	SetEvent(m_stopEvent);
+	m_thread.join();
+}
+
+void KeyboardInput::Run()
+{
+	HANDLE handles[] = { m_input, m_stopEvent };
+	while (WaitForMultipleObjects(2, handles, FALSE, INFINITE) == WAIT_OBJECT_0)
+	{
+		bool queued = false;
+		while (IsKeyWaiting(m_input))
+		{
+			int key = _getch();
+			// already there, it came with the same key press
+			int extendedKey = key == 0 || key == kExtendedKey ? _getch() : 0;
+			queued = Queue(key, extendedKey) || queued;
+		}
+
+		if (queued)
+		{
+			SetEvent(m_keyEvent);
+		}
+	}
+}
+#else
+// turns what the terminal sent for a key into what _getch() returns for it.
+// Returns how many bytes that took, key is -1 for a sequence the game has
+// no use for
+static size_t ParseKey(const unsigned char* data, size_t length, int& key, int& extendedKey)
+{
+	key = data[0];
+	extendedKey = 0;
+	if (key == 127)
+	{
+		// backspace
+		key = 8;
+	}
+	// escape on its own unless a whole sequence follows right away, the
+	// terminal sends those in one go
+	if (key != 27 || length < 3 || (data[1] != '[' && data[1] != 'O'))
+	{
+		return 1;
+	}
+
+	size_t end = 2;
+	while (end < length && (data[end] < 0x40 || data[end] > 0x7E))
+	{
+		++end;
+	}
+	if (end == length)
+	{
+		return 1;
+	}
+
+	key = kExtendedKey;
+	switch (data[end])
+	{
+	case 'A':
+		extendedKey = 72;
+		break;
+	case 'B':
+		extendedKey = 80;
+		break;
+	case 'C':
+		extendedKey = 77;
+		break;
+	case 'D':
+		extendedKey = 75;
+		break;
+	case 'H':
+		extendedKey = 71;
+		break;
+	case 'F':
+		extendedKey = 79;
+		break;
+	case '~':
+		// delete
+		if (end == 3 && data[2] == '3')
+		{
+			extendedKey = 83;
+			break;
+		}
+		key = -1;
+		break;
+	default:
+		key = -1;
+		break;
+	}
+	return end + 1;
+}
+
+KeyboardInput::KeyboardInput()
+	: m_keyPipe{ -1, -1 }
+	, m_stopPipe{ -1, -1 }
+	, m_keys(kKeyQueueSize)
+{
+	if (pipe(m_keyPipe) == 0)
+	{
+		// a full pipe is as good as a signal
+		fcntl(m_keyPipe[0], F_SETFL, O_NONBLOCK);
+		fcntl(m_keyPipe[1], F_SETFL, O_NONBLOCK);
+	}
+	if (pipe(m_stopPipe) != 0)
+	{
+		m_stopPipe[0] = -1;
+		m_stopPipe[1] = -1;
+	}
+}
+
+KeyboardInput::~KeyboardInput()
+{
+	Stop();
+	for (int fd : { m_keyPipe[0], m_keyPipe[1], m_stopPipe[0], m_stopPipe[1] })
+	{
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+	}
+}
+
+bool KeyboardInput::Start()
+{
+	if (m_thread.joinable())
+	{
+		return true;
+	}
+	if (m_keyPipe[0] < 0 || m_stopPipe[0] < 0)
+	{
+		return false;
+	}
+
+	m_thread = std::thread(&KeyboardInput::Run, this);
+	return true;
+}
+
+void KeyboardInput::Stop()
+{
+	if (!m_thread.joinable())
+	{
+		return;
+	}
+
+	char stop = 1;
+	while (write(m_stopPipe[1], &stop, 1) < 0 && errno == EINTR)
+	{
+	}
+	m_thread.join();
+
+	// ready for the next Start()
+	while (read(m_stopPipe[0], &stop, 1) < 0 && errno == EINTR)
+	{
+	}
+}
+
+void KeyboardInput::ClearKeySignal()
+{
+	char signals[64];
+	while (read(m_keyPipe[0], signals, sizeof(signals)) > 0)
+	{
+	}
+}
+
+void KeyboardInput::Run()
+{
+	pollfd fds[2] = {};
+	fds[0].fd = STDIN_FILENO;
+	fds[0].events = POLLIN;
+	fds[1].fd = m_stopPipe[0];
+	fds[1].events = POLLIN;
+
+	unsigned char buffer[256];
+	while (true)
+	{
+		if (poll(fds, 2, -1) < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			break;
+		}
+		if (fds[1].revents != 0)
+		{
+			break;
+		}
+
+		ssize_t length = read(STDIN_FILENO, buffer, sizeof(buffer));
+		if (length < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (length <= 0)
+		{
+			// no keyboard to read, like with input from /dev/null
+			break;
+		}
+
+		bool queued = false;
+		size_t offset = 0;
+		while (offset < static_cast<size_t>(length))
+		{
+			int key = 0;
+			int extendedKey = 0;
+			offset += ParseKey(buffer + offset, static_cast<size_t>(length) - offset, key, extendedKey);
+			if (key >= 0)
+			{
+				queued = Queue(key, extendedKey) || queued;
+			}
+		}
+
+		if (queued)
+		{
+			char signal = 1;
+			while (write(m_keyPipe[1], &signal, 1) < 0 && errno == EINTR)
+			{
+			}
+		}
+	}
+}
+#endif
+
+bool KeyboardInput::Pop(KeyEvent& event)
+{
+	return m_keys.TryPop(event);
+}
+
+bool KeyboardInput::HasKeys() const
+{
+	return !m_keys.IsEmpty();
+}
+
+bool KeyboardInput::Queue(int key, int extendedKey)
+{
+	KeyEvent event;
+	event.key = key;
+	event.extendedKey = extendedKey;
+	event.time = std::chrono::steady_clock::now();
+
+	// a key the game didn't get to before hundreds more were pressed is
+	// dropped
+	return m_keys.TryPush(event);
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "SpscQueue.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <chrono>
+#include <thread>
+
+struct KeyEvent
+{
+	// what _getch() returns, on Linux too
+	int key;
+	// the second code of arrow keys and the like, which _getch() returns
+	// as 0 or 224 followed by this. 0 for any other key
+	int extendedKey;
+	// when the input thread read it
+	std::chrono::steady_clock::time_point time;
+};
+
+// Reads the keyboard on a thread of its own for as long as the game runs
+// and queues every key pressed for the game loop. The thread sleeps on
+// the console input until there is a key to read, so reading one never
+// blocks and no thread is started per key. On Linux it reads the
+// terminal, which Terminal has sending keys as they are pressed, and
+// turns the escape sequences of arrow keys into what _getch() returns for
+// them. Only the game loop's thread pops keys
+class KeyboardInput
+{
+public:
+	~KeyboardInput();
+
+	static KeyboardInput& GetInstance()
+	{
+		static KeyboardInput instance;
+		return instance;
+	}
+
+	// starts the input thread, once
+	bool Start();
+	void Stop();
+
+	// takes the oldest key pressed, false if there is none
+	bool Pop(KeyEvent& event);
+	bool HasKeys() const;
+#ifdef _WIN32
+	// signalled when a key is queued, to wait on it along with other things
+	HANDLE GetKeyEvent() const { return m_keyEvent; }
+#else
+	// readable when a key is queued, to wait on it along with other things.
+	// Stays readable until ClearKeySignal()
+	int GetKeyFd() const { return m_keyPipe[0]; }
+	void ClearKeySignal();
+#endif
+
+private:
+	KeyboardInput();
+
+	void Run();
+	// false if the game is too far behind to take it
+	bool Queue(int key, int extendedKey);
+
+#ifdef _WIN32
+	HANDLE m_input;
+	HANDLE m_keyEvent;
+	HANDLE m_stopEvent;
+#else
+	int m_keyPipe[2];
+	int m_stopPipe[2];
+#endif
+	std::thread m_thread;
+
+	SpscQueue<KeyEvent> m_keys;
+};
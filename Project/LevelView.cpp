@@ -0,0 +1,63 @@
+#include "LevelView.h"
+#include "Level.h"
+#include "Player.h"
+#include "Door.h"
+#include "Renderer.h"
+
+void LevelView::Draw(Level& level)
+{
+	Renderer& renderer = Renderer::GetInstance();
+
+	// Draw the Level
+	for (int y = 0; y < level.GetHeight(); ++y)
+	{
+		for (int x = 0; x < level.GetWidth(); ++x)
+		{
+			renderer.Draw(x, y, level.GetTile(x, y), (int)ActorColor::Regular);
+		}
+	}
+
+	// Draw actors
+	for (PlacableActor* actor : level.GetActors())
+	{
+		if (actor->IsActive())
+		{
+			DrawActor(*actor, actor->GetXPosition(), actor->GetYPosition());
+		}
+	}
+}
+
+void LevelView::DrawActor(PlacableActor& actor, int x, int y)
+{
+	Renderer& renderer = Renderer::GetInstance();
+
+	switch (actor.GetType())
+	{
+	case ActorType::Door:
+	{
+		Door& door = dynamic_cast<Door&>(actor);
+		renderer.Draw(x, y, '|', (int)(door.IsOpen() ? door.GetColor() : door.GetClosedColor()));
+		break;
+	}
+	case ActorType::Enemy:
+		renderer.Draw(x, y, (char)153);
+		break;
+	case ActorType::Goal:
+		renderer.Draw(x, y, 'X');
+		break;
+	case ActorType::Key:
+		renderer.Draw(x, y, '+', (int)actor.GetColor());
+		break;
+	case ActorType::Money:
+		renderer.Draw(x, y, '$');
+		break;
+	case ActorType::Player:
+	{
+		Player& player = dynamic_cast<Player&>(actor);
+		renderer.Draw(x, y, player.IsOwnPlayer() ? '@' : '#');
+		break;
+	}
+	default:
+		break;
+	}
+}
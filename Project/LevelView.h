@@ -0,0 +1,15 @@
+#pragma once
+
+class Level;
+class PlacableActor;
+
+// How the level and its actors look. They only know the game's rules, so
+// what each of them is drawn as is decided here
+class LevelView
+{
+public:
+	// the tiles, then every actor still in the level
+	static void Draw(Level& level);
+	// at x, y rather than where the actor is, to show it elsewhere too
+	static void DrawActor(PlacableActor& actor, int x, int y);
+};
@@ -1,12 +1,9 @@
 #include "LoseState.h"
 
-#include <iostream>
-#include <conio.h>
-
+#include "KeyboardInput.h"
+#include "Renderer.h"
 #include "StateMachineExampleGame.h"
 
-using namespace std;
-
 
 LoseState::LoseState(StateMachineExampleGame* pOwner)
 	: m_pOwner(pOwner)
@@ -15,9 +12,9 @@ LoseState::LoseState(StateMachineExampleGame* pOwner)
 
 bool LoseState::Update(bool processInput)
 {
-	if (processInput)
+	KeyEvent key;
+	if (processInput && KeyboardInput::GetInstance().Pop(key))
 	{
-		int input = _getch();
 		m_pOwner->LoadScene(StateMachineExampleGame::SceneName::MainMenu);
 	}
 	return false;
@@ -25,9 +22,8 @@ bool LoseState::Update(bool processInput)
 
 void LoseState::Draw()
 {
-	system("cls");
-	cout << endl << endl << endl;
-	cout << "          - - - GAME OVER - - -" << endl << endl;
-	cout << "             Better luck next time." << endl << endl << endl;
-	cout << "             Press any key to go back to the main menu" << endl << endl << endl;
+	Renderer& renderer = Renderer::GetInstance();
+	renderer.DrawText(10, 3, "- - - GAME OVER - - -");
+	renderer.DrawText(13, 5, "Better luck next time.");
+	renderer.DrawText(13, 8, "Press any key to go back to the main menu");
 }
\ No newline at end of file
@@ -1,12 +1,9 @@
 #include "MainMenuState.h"
 
-#include <iostream>
-#include <conio.h>
-
+#include "KeyboardInput.h"
+#include "Renderer.h"
 #include "StateMachineExampleGame.h"
 
-using namespace std;
-
 constexpr int kEscapeKey = 27;
 
 constexpr char kPlay = '1';
@@ -22,9 +19,12 @@ MainMenuState::MainMenuState(StateMachineExampleGame* pOwner)
 bool MainMenuState::Update(bool processInput)
 {
 	bool shouldQuit = false;
-	if (processInput)
+	// one key at a time, the ones after a key that picks another scene
+	// are for that scene
+	KeyEvent key;
+	if (processInput && KeyboardInput::GetInstance().Pop(key))
 	{
-		int input = _getch();
+		int input = key.key;
 		if (input == kEscapeKey || (char)input == kQuit)
 		{
 			shouldQuit = true;
@@ -47,11 +47,10 @@ bool MainMenuState::Update(bool processInput)
 
 void MainMenuState::Draw()
 {
-	system("cls");
-	cout << endl << endl << endl;
-	cout << "          - - - MAIN MENU - - -" << endl << endl;
-	cout << "             " << kPlay << ". Play " << endl;
-	cout << "             " << kHighScore << ". High Score " << endl;
-	cout << "             " << kSettings << ". Settings " << endl;
-	cout << "             " << kQuit << ". Quit " << endl;
+	Renderer& renderer = Renderer::GetInstance();
+	renderer.DrawText(10, 3, "- - - MAIN MENU - - -");
+	renderer.DrawText(13, 5, std::string(1, kPlay) + ". Play ");
+	renderer.DrawText(13, 6, std::string(1, kHighScore) + ". High Score ");
+	renderer.DrawText(13, 7, std::string(1, kSettings) + ". Settings ");
+	renderer.DrawText(13, 8, std::string(1, kQuit) + ". Quit ");
 }
\ No newline at end of file
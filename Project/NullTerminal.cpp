@@ -0,0 +1,74 @@
+#include "NullTerminal.h"
+
+#include <algorithm>
+
+NullTerminal::NullTerminal(int width, int height)
+	: m_width(width)
+	, m_height(height)
+	, m_glyphs(static_cast<size_t>(width) * height, ' ')
+	, m_colors(m_glyphs.size(), kDefaultColor)
+	, m_cursorX(0)
+	, m_cursorY(0)
+	, m_color(kDefaultColor)
+	, m_written(0)
+	, m_moves(0)
+	, m_colorChanges(0)
+{
+}
+
+void NullTerminal::GetSize(int& width, int& height)
+{
+	width = m_width;
+	height = m_height;
+}
+
+void NullTerminal::Clear()
+{
+	std::fill(m_glyphs.begin(), m_glyphs.end(), ' ');
+	std::fill(m_colors.begin(), m_colors.end(), m_color);
+	m_cursorX = 0;
+	m_cursorY = 0;
+}
+
+void NullTerminal::MoveCursor(int x, int y)
+{
+	m_cursorX = x;
+	m_cursorY = y;
+	m_moves++;
+}
+
+void NullTerminal::SetColor(int color)
+{
+	m_color = color;
+	m_colorChanges++;
+}
+
+void NullTerminal::Write(char glyph)
+{
+	if (m_cursorX >= 0 && m_cursorY >= 0 && m_cursorX < m_width && m_cursorY < m_height)
+	{
+		size_t index = m_cursorX + static_cast<size_t>(m_cursorY) * m_width;
+		m_glyphs[index] = glyph;
+		m_colors[index] = m_color;
+	}
+	m_cursorX++;
+	m_written++;
+}
+
+char NullTerminal::GetGlyph(int x, int y) const
+{
+	if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+	{
+		return ' ';
+	}
+	return m_glyphs[x + static_cast<size_t>(y) * m_width];
+}
+
+int NullTerminal::GetColor(int x, int y) const
+{
+	if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+	{
+		return kDefaultColor;
+	}
+	return m_colors[x + static_cast<size_t>(y) * m_width];
+}
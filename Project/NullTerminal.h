@@ -0,0 +1,44 @@
+#pragma once
+#include "Terminal.h"
+
+#include <cstddef>
+#include <vector>
+
+// Keeps the screen in memory and shows nothing, for running without a
+// console like in benchmarks. What a real terminal would show can be read
+// back from it
+class NullTerminal : public Terminal
+{
+public:
+	NullTerminal(int width = 80, int height = 25);
+
+	virtual bool Start() override { return true; }
+	virtual void Stop() override {}
+	virtual void GetSize(int& width, int& height) override;
+
+	virtual void Clear() override;
+	virtual void MoveCursor(int x, int y) override;
+	virtual void SetColor(int color) override;
+	virtual void Write(char glyph) override;
+	virtual void Flush() override {}
+
+	char GetGlyph(int x, int y) const;
+	int GetColor(int x, int y) const;
+	// since it was created, what the frames so far took
+	size_t GetWrittenCount() const { return m_written; }
+	size_t GetMoveCount() const { return m_moves; }
+	size_t GetColorChangeCount() const { return m_colorChanges; }
+
+private:
+	int m_width;
+	int m_height;
+	std::vector<char> m_glyphs;
+	std::vector<int> m_colors;
+
+	int m_cursorX;
+	int m_cursorY;
+	int m_color;
+	size_t m_written;
+	size_t m_moves;
+	size_t m_colorChanges;
+};
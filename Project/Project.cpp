@@ -1,4 +1,6 @@
+#ifdef _WIN32
 #include "vld.h"
+#endif
 #include <iostream>
 #include "Game.h"
 #include "AudioManager.h"
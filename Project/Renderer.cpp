@@ -0,0 +1,150 @@
+#include "Renderer.h"
+
+#include <algorithm>
+
+// moving the cursor takes up to 10 bytes of escape sequence or a call into
+// the console, a few cells that didn't change are cheaper to write again
+// when they are in the way
+constexpr int kMaxCellsSkipped = 4;
+// for a terminal that can't tell its size
+constexpr int kDefaultWidth = 80;
+constexpr int kDefaultHeight = 25;
+
+Renderer::Renderer()
+	: m_pTerminal(nullptr)
+	, m_fullRedraw(true)
+	, m_width(0)
+	, m_height(0)
+	, m_cursorX(-1)
+	, m_cursorY(-1)
+	, m_color(-1)
+{
+}
+
+void Renderer::SetTerminal(Terminal* pTerminal)
+{
+	m_pTerminal = pTerminal;
+	m_fullRedraw = true;
+}
+
+void Renderer::BeginFrame()
+{
+	int width = kDefaultWidth;
+	int height = kDefaultHeight;
+	if (m_pTerminal != nullptr)
+	{
+		m_pTerminal->GetSize(width, height);
+	}
+	if (width != m_width || height != m_height)
+	{
+		Resize(width, height);
+	}
+
+	Cell blank = { ' ', static_cast<uint8_t>(kDefaultColor) };
+	std::fill(m_back.begin(), m_back.end(), blank);
+}
+
+void Renderer::Draw(int x, int y, char glyph, int color)
+{
+	// NOTE: the bottom right cell is left alone, writing it makes some
+	// terminals scroll the whole screen up a line
+	if (x < 0 || y < 0 || x >= m_width || y >= m_height || (x == m_width - 1 && y == m_height - 1))
+	{
+		return;
+	}
+
+	Cell& cell = m_back[x + y * m_width];
+	cell.glyph = glyph;
+	cell.color = static_cast<uint8_t>(color);
+}
+
+int Renderer::DrawText(int x, int y, const std::string& text, int color)
+{
+	for (char glyph : text)
+	{
+		Draw(x++, y, glyph, color);
+	}
+	return x;
+}
+
+void Renderer::Present()
+{
+	if (m_pTerminal == nullptr)
+	{
+		return;
+	}
+
+	if (m_fullRedraw)
+	{
+		// a cleared screen is blank cells, those don't need writing again
+		m_pTerminal->Clear();
+		Cell blank = { ' ', static_cast<uint8_t>(kDefaultColor) };
+		std::fill(m_front.begin(), m_front.end(), blank);
+		m_cursorX = -1;
+		m_cursorY = -1;
+		m_color = -1;
+		SetColor(kDefaultColor);
+		m_fullRedraw = false;
+	}
+
+	for (int y = 0; y < m_height; ++y)
+	{
+		for (int x = 0; x < m_width; ++x)
+		{
+			int index = x + y * m_width;
+			if (m_back[index] == m_front[index])
+			{
+				continue;
+			}
+
+			if (m_cursorY == y && m_cursorX < x && x - m_cursorX <= kMaxCellsSkipped)
+			{
+				// write the unchanged cells in between again instead
+				for (int skipped = m_cursorX; skipped < x; ++skipped)
+				{
+					const Cell& cell = m_front[skipped + y * m_width];
+					SetColor(cell.color);
+					m_pTerminal->Write(cell.glyph);
+				}
+			}
+			else if (m_cursorY != y || m_cursorX != x)
+			{
+				m_pTerminal->MoveCursor(x, y);
+				m_cursorX = x;
+				m_cursorY = y;
+			}
+
+			SetColor(m_back[index].color);
+			m_pTerminal->Write(m_back[index].glyph);
+			m_front[index] = m_back[index];
+			m_cursorX = x + 1;
+			m_cursorY = y;
+		}
+	}
+
+	m_pTerminal->Flush();
+}
+
+void Renderer::Invalidate()
+{
+	m_fullRedraw = true;
+}
+
+void Renderer::Resize(int width, int height)
+{
+	m_width = width > 0 ? width : 0;
+	m_height = height > 0 ? height : 0;
+	m_back.resize(static_cast<size_t>(m_width) * m_height);
+	m_front.resize(m_back.size());
+	// the terminal moved things around itself
+	m_fullRedraw = true;
+}
+
+void Renderer::SetColor(uint8_t color)
+{
+	if (color != m_color)
+	{
+		m_pTerminal->SetColor(color);
+		m_color = color;
+	}
+}
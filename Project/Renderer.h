@@ -0,0 +1,68 @@
+#pragma once
+#include "Terminal.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Draws the game into a grid of cells instead of straight to the screen.
+// Present() compares the grid with the frame before and hands only the
+// cells that changed to the terminal, so the screen is never cleared in
+// between and doesn't flicker
+class Renderer
+{
+public:
+	static constexpr int kDefaultColor = Terminal::kDefaultColor;
+
+	static Renderer& GetInstance()
+	{
+		static Renderer instance;
+		return instance;
+	}
+
+	// where frames go from now on, nullptr for nowhere. The first frame
+	// on it is drawn whole
+	void SetTerminal(Terminal* pTerminal);
+
+	// starts an empty frame the size of the terminal
+	void BeginFrame();
+	// anything outside the window is left out
+	void Draw(int x, int y, char glyph, int color = kDefaultColor);
+	// returns the column after the text
+	int DrawText(int x, int y, const std::string& text, int color = kDefaultColor);
+	// writes the cells that changed since the last frame
+	void Present();
+
+	// the next Present() draws every cell, for when something else wrote
+	// to the screen in the meantime
+	void Invalidate();
+
+private:
+	struct Cell
+	{
+		char glyph;
+		uint8_t color;
+
+		bool operator==(const Cell& other) const { return glyph == other.glyph && color == other.color; }
+		bool operator!=(const Cell& other) const { return !(*this == other); }
+	};
+
+	Renderer();
+
+	void Resize(int width, int height);
+	void SetColor(uint8_t color);
+
+	Terminal* m_pTerminal;
+	bool m_fullRedraw;
+
+	int m_width;
+	int m_height;
+	// being drawn, and what the terminal shows
+	std::vector<Cell> m_back;
+	std::vector<Cell> m_front;
+
+	// where the terminal has them, to leave out what wouldn't change
+	int m_cursorX;
+	int m_cursorY;
+	int m_color;
+};
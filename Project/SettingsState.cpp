@@ -1,13 +1,10 @@
 #include "SettingsState.h"
 
-#include <iostream>
-#include <conio.h>
-
+#include "KeyboardInput.h"
+#include "Renderer.h"
 #include "StateMachineExampleGame.h"
 #include "AudioManager.h"
 
-using namespace std;
-
 constexpr int kEscapeKey = 27;
 constexpr char kSound = '1';
 constexpr char kMainMenu = '2';
@@ -19,9 +16,10 @@ SettingsState::SettingsState(StateMachineExampleGame* pOwner)
 
 bool SettingsState::Update(bool processInput)
 {
-	if (processInput)
+	KeyEvent key;
+	if (processInput && KeyboardInput::GetInstance().Pop(key))
 	{
-		int input = _getch();
+		int input = key.key;
 		if (input == kEscapeKey || (char)input == kMainMenu)
 		{
 			m_pOwner->LoadScene(StateMachineExampleGame::SceneName::MainMenu);
@@ -40,17 +38,16 @@ bool SettingsState::Update(bool processInput)
 
 void SettingsState::Draw()
 {
-	system("cls");
-	cout << endl << endl << endl;
-	cout << "          - - - Settings - - -" << endl << endl;
-	cout << "             " << kSound << ". Toggle Sound: ";
+	Renderer& renderer = Renderer::GetInstance();
+	renderer.DrawText(10, 3, "- - - Settings - - -");
+	int x = renderer.DrawText(13, 5, std::string(1, kSound) + ". Toggle Sound: ");
 	if (AudioManager::GetInstance()->IsSoundOn())
 	{
-		cout << "ON" << endl;
+		renderer.DrawText(x, 5, "ON");
 	}
 	else
 	{
-		cout << "OFF" << endl;
+		renderer.DrawText(x, 5, "OFF");
 	}
-	cout << "             " << kMainMenu << ". Back to Main Menu " << endl;
+	renderer.DrawText(13, 6, std::string(1, kMainMenu) + ". Back to Main Menu ");
 }
\ No newline at end of file
@@ -11,6 +11,7 @@ StateMachineExampleGame::StateMachineExampleGame(Game* pOwner)
 	: m_pOwner(pOwner)
 	, m_pCurrentState(nullptr)
 	, m_pNextState(nullptr)
+	, m_stateChanged(false)
 {
 }
 
@@ -33,6 +34,14 @@ bool StateMachineExampleGame::UpdateCurrentState(bool processInput)
 	{
 		done = m_pCurrentState->Update(processInput);
 	}
+
+	// a key that picked another scene shows it straight away instead of
+	// on the next update, which may be a while off
+	if (m_pNextState != nullptr)
+	{
+		ChangeState(m_pNextState);
+		m_pNextState = nullptr;
+	}
 	return done;
 }
 
@@ -42,6 +51,21 @@ void StateMachineExampleGame::DrawCurrentState()
 	{
 		m_pCurrentState->Draw();
 	}
+	m_stateChanged = false;
+}
+
+int StateMachineExampleGame::GetUpdateIntervalMs() const
+{
+	if (m_pCurrentState != nullptr)
+	{
+		return m_pCurrentState->GetUpdateIntervalMs();
+	}
+	return GameState::kIdleUpdateMs;
+}
+
+bool StateMachineExampleGame::NeedsRedraw() const
+{
+	return m_stateChanged || (m_pCurrentState != nullptr && m_pCurrentState->NeedsRedraw());
 }
 
 void StateMachineExampleGame::ChangeState(GameState* pNewState)
@@ -54,6 +78,7 @@ void StateMachineExampleGame::ChangeState(GameState* pNewState)
 	delete m_pCurrentState;
 	m_pCurrentState = pNewState;
 	pNewState->Enter();
+	m_stateChanged = true;
 }
 
 void StateMachineExampleGame::LoadScene(SceneName scene)
@@ -23,6 +23,7 @@ private:
 
 	GameState* m_pCurrentState;
 	GameState* m_pNextState;
+	bool m_stateChanged;
 
 public:
 	StateMachineExampleGame(Game* pOwner);
@@ -30,8 +31,12 @@ public:
 	virtual bool Init() override;
 	virtual bool UpdateCurrentState(bool processInput = true) override;
 	virtual void DrawCurrentState() override;
+	virtual int GetUpdateIntervalMs() const override;
+	virtual bool NeedsRedraw() const override;
 	virtual void ChangeState(GameState* pNewState) override;
 	void LoadScene(SceneName scene);
+	// a scene was loaded and takes over after the current update
+	bool IsChangingScene() const { return m_pNextState != nullptr; }
 	virtual bool Cleanup() override;
 };
 
@@ -0,0 +1,28 @@
+#include "Terminal.h"
+
+#include "AnsiTerminal.h"
+#include "NullTerminal.h"
+#include "Win32Terminal.h"
+
+std::unique_ptr<Terminal> Terminal::Create()
+{
+	std::unique_ptr<Terminal> terminal(new AnsiTerminal());
+	if (terminal->Start())
+	{
+		return terminal;
+	}
+
+#ifdef _WIN32
+	// a console from before Windows 10
+	terminal.reset(new Win32Terminal());
+	if (terminal->Start())
+	{
+		return terminal;
+	}
+#endif
+
+	// output isn't going to a terminal at all
+	terminal.reset(new NullTerminal());
+	terminal->Start();
+	return terminal;
+}
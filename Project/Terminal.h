@@ -0,0 +1,35 @@
+#pragma once
+#include <memory>
+
+// Where Renderer's frames end up. Colors are console attributes as
+// ActorColor has them, foreground in the low 4 bits and background in the
+// high ones, with blue in the lowest bit of each. Glyphs are code page 437
+// like the level files. Output may be held back until Flush(), which is
+// called once a frame
+class Terminal
+{
+public:
+	// grey on black
+	static constexpr int kDefaultColor = 7;
+
+	virtual ~Terminal() {}
+
+	// the best one the console or terminal the game runs in supports,
+	// already started. Never nullptr, NullTerminal if nothing else works
+	static std::unique_ptr<Terminal> Create();
+
+	// takes over the screen, returns false if it can't drive it
+	virtual bool Start() = 0;
+	// leaves the screen as it was found
+	virtual void Stop() = 0;
+
+	virtual void GetSize(int& width, int& height) = 0;
+
+	// blanks the screen, where the cursor ends up is up to the terminal
+	virtual void Clear() = 0;
+	virtual void MoveCursor(int x, int y) = 0;
+	virtual void SetColor(int color) = 0;
+	// at the cursor, which moves one to the right
+	virtual void Write(char glyph) = 0;
+	virtual void Flush() = 0;
+};
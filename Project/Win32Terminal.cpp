@@ -0,0 +1,109 @@
+#include "Win32Terminal.h"
+#ifdef _WIN32
+
+Win32Terminal::Win32Terminal()
+	: m_console(GetStdHandle(STD_OUTPUT_HANDLE))
+	, m_started(false)
+	, m_cursorInfo()
+	, m_attributes(kDefaultColor)
+{
+}
+
+Win32Terminal::~Win32Terminal()
+{
+	Stop();
+}
+
+bool Win32Terminal::Start()
+{
+	CONSOLE_SCREEN_BUFFER_INFO csbi;
+	if (m_started || !GetConsoleScreenBufferInfo(m_console, &csbi))
+	{
+		return m_started;
+	}
+
+	m_attributes = csbi.wAttributes;
+	GetConsoleCursorInfo(m_console, &m_cursorInfo);
+	CONSOLE_CURSOR_INFO hidden = m_cursorInfo;
+	hidden.bVisible = FALSE;
+	SetConsoleCursorInfo(m_console, &hidden);
+	m_started = true;
+	return true;
+}
+
+void Win32Terminal::Stop()
+{
+	if (!m_started)
+	{
+		return;
+	}
+
+	Flush();
+	SetConsoleTextAttribute(m_console, m_attributes);
+	Clear();
+	SetConsoleCursorInfo(m_console, &m_cursorInfo);
+	m_started = false;
+}
+
+void Win32Terminal::GetSize(int& width, int& height)
+{
+	CONSOLE_SCREEN_BUFFER_INFO csbi;
+	if (GetConsoleScreenBufferInfo(m_console, &csbi))
+	{
+		width = csbi.srWindow.Right - csbi.srWindow.Left + 1;
+		height = csbi.srWindow.Bottom - csbi.srWindow.Top + 1;
+	}
+}
+
+void Win32Terminal::Clear()
+{
+	Flush();
+
+	CONSOLE_SCREEN_BUFFER_INFO csbi;
+	if (!GetConsoleScreenBufferInfo(m_console, &csbi))
+	{
+		return;
+	}
+
+	// what system("cls") does, without starting a shell for it
+	COORD home = { 0, 0 };
+	DWORD size = static_cast<DWORD>(csbi.dwSize.X) * csbi.dwSize.Y;
+	DWORD written = 0;
+	FillConsoleOutputCharacterA(m_console, ' ', size, home, &written);
+	FillConsoleOutputAttribute(m_console, csbi.wAttributes, size, home, &written);
+	SetConsoleCursorPosition(m_console, home);
+}
+
+void Win32Terminal::MoveCursor(int x, int y)
+{
+	Flush();
+
+	COORD position;
+	position.X = static_cast<SHORT>(x);
+	position.Y = static_cast<SHORT>(y);
+	SetConsoleCursorPosition(m_console, position);
+}
+
+void Win32Terminal::SetColor(int color)
+{
+	Flush();
+	SetConsoleTextAttribute(m_console, static_cast<WORD>(color));
+}
+
+void Win32Terminal::Write(char glyph)
+{
+	m_run += glyph;
+}
+
+void Win32Terminal::Flush()
+{
+	if (m_run.empty())
+	{
+		return;
+	}
+
+	DWORD written = 0;
+	WriteConsoleA(m_console, m_run.data(), static_cast<DWORD>(m_run.size()), &written, nullptr);
+	m_run.clear();
+}
+#endif
@@ -0,0 +1,36 @@
+#pragma once
+#ifdef _WIN32
+#include "Terminal.h"
+
+#include <windows.h>
+#include <string>
+
+// Console API output for consoles without virtual terminal sequences.
+// Glyphs written one after the other in the same color go out in a
+// single WriteConsoleA() call
+class Win32Terminal : public Terminal
+{
+public:
+	Win32Terminal();
+	~Win32Terminal();
+
+	virtual bool Start() override;
+	virtual void Stop() override;
+	virtual void GetSize(int& width, int& height) override;
+
+	virtual void Clear() override;
+	virtual void MoveCursor(int x, int y) override;
+	virtual void SetColor(int color) override;
+	virtual void Write(char glyph) override;
+	virtual void Flush() override;
+
+private:
+	HANDLE m_console;
+	bool m_started;
+	CONSOLE_CURSOR_INFO m_cursorInfo;
+	WORD m_attributes;
+
+	// glyphs at the cursor not written yet
+	std::string m_run;
+};
+#endif
@@ -1,12 +1,9 @@
 #include "WinState.h"
 
-#include <iostream>
-#include <conio.h>
-
+#include "KeyboardInput.h"
+#include "Renderer.h"
 #include "StateMachineExampleGame.h"
 
-using namespace std;
-
 
 WinState::WinState(StateMachineExampleGame* pOwner)
 	: m_pOwner(pOwner)
@@ -15,9 +12,9 @@ WinState::WinState(StateMachineExampleGame* pOwner)
 
 bool WinState::Update(bool processInput)
 {
-	if (processInput)
+	KeyEvent key;
+	if (processInput && KeyboardInput::GetInstance().Pop(key))
 	{
-		int input = _getch();
 		m_pOwner->LoadScene(StateMachineExampleGame::SceneName::MainMenu);
 	}
 	return false;
@@ -25,9 +22,8 @@ bool WinState::Update(bool processInput)
 
 void WinState::Draw()
 {
-	system("cls");
-	cout << endl << endl << endl;
-	cout << "          - - - WELL DONE - - -" << endl << endl;
-	cout << "             You beat the game!" << endl << endl << endl;
-	cout << "             Press any key to go back to the main menu" << endl << endl << endl;
+	Renderer& renderer = Renderer::GetInstance();
+	renderer.DrawText(10, 3, "- - - WELL DONE - - -");
+	renderer.DrawText(13, 5, "You beat the game!");
+	renderer.DrawText(13, 8, "Press any key to go back to the main menu");
 }
\ No newline at end of file
@@ -0,0 +1,440 @@
+#include "NetCommon.h"
+#include "PacketCompression.h"
+#include "Protocol.h"
+#include "RenderBench.h"
+
+#include <enet/enet.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Compares the binary wire format against the old "peerId-x,y" text format:
+// time to encode and decode what a client sends per step (a position report
+// then, an input now) and a snapshot, and the bytes each one puts on the
+// wire. Also measures a delta snapshot, where only a
+// few players moved since the baseline the client acknowledged.
+// Then compresses the datagrams those messages go out in with each of the
+// compressors a host can use, for the ratio and the time it costs per
+// datagram
+
+const int LEVEL_WIDTH = 200;
+const int LEVEL_HEIGHT = 60;
+const int ITERATIONS = 200000;
+const int SNAPSHOT_PLAYERS = 32;
+const int DELTA_MOVED_PLAYERS = 4;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// keeps the optimizer from throwing the benchmarked work away
+volatile int g_sink = 0;
+
+std::vector<Protocol::PlayerPosition> MakePlayers(int count)
+{
+    std::vector<Protocol::PlayerPosition> players;
+    for (int i = 0; i < count; ++i)
+    {
+        Protocol::PlayerPosition player;
+        player.peerId = static_cast<uint32_t>(i);
+        player.x = rand() % LEVEL_WIDTH;
+        player.y = rand() % LEVEL_HEIGHT;
+        players.push_back(player);
+    }
+    return players;
+}
+
+// the text format as GameplayState used to build and parse it
+std::string TextEncodePosition(int peerId, int x, int y)
+{
+    std::stringstream stringStream;
+    stringStream << peerId << "-" << x << "," << y;
+    return stringStream.str();
+}
+
+void TextDecodePosition(const std::string& dataStr, int& peerID, int& x, int& y)
+{
+    const auto dataPrefixPos = dataStr.find("-");
+
+    std::string peerIDStr = dataStr.substr(0, dataPrefixPos);
+    peerID = atoi(peerIDStr.c_str());
+
+    std::string positionStr = dataStr.substr(dataPrefixPos + 1, dataStr.size() - peerIDStr.size() - 1);
+
+    const auto findPos = positionStr.find(",");
+
+    std::string strX = positionStr.substr(0, findPos);
+    std::string strY = positionStr.substr(findPos + 1, positionStr.size() - strX.size() - 1);
+
+    x = atoi(strX.c_str());
+    y = atoi(strY.c_str());
+}
+
+std::string TextEncodeSnapshot(const std::vector<Protocol::PlayerPosition>& players)
+{
+    std::stringstream snapshot;
+    for (size_t i = 0; i < players.size(); ++i)
+    {
+        if (i > 0)
+        {
+            snapshot << ";";
+        }
+        snapshot << players[i].peerId << "-" << players[i].x << "," << players[i].y;
+    }
+    return snapshot.str();
+}
+
+void TextDecodeSnapshot(const std::string& data, std::vector<Protocol::PlayerPosition>& players)
+{
+    players.clear();
+    std::stringstream snapshot(data);
+    std::string entry;
+    while (std::getline(snapshot, entry, ';'))
+    {
+        Protocol::PlayerPosition player;
+        int peerId = 0;
+        TextDecodePosition(entry, peerId, player.x, player.y);
+        player.peerId = static_cast<uint32_t>(peerId);
+        players.push_back(player);
+    }
+}
+
+double NanosecondsPerIteration(Clock::time_point start)
+{
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    return static_cast<double>(elapsed) / ITERATIONS;
+}
+
+void Report(const char* name, double encodeNs, double decodeNs, size_t bytes)
+{
+    std::cout << "  " << name << ": encode " << encodeNs << " ns, decode " << decodeNs
+        << " ns, " << bytes << " bytes" << std::endl;
+}
+
+void BenchStep()
+{
+    std::cout << "Step (" << LEVEL_WIDTH << "x" << LEVEL_HEIGHT << " level)" << std::endl;
+
+    auto players = MakePlayers(ITERATIONS);
+
+    // text
+    size_t textBytes = 0;
+    std::vector<std::string> encoded(ITERATIONS);
+    auto start = Clock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        encoded[i] = TextEncodePosition(players[i].peerId, players[i].x, players[i].y);
+    }
+    double textEncode = NanosecondsPerIteration(start);
+
+    start = Clock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        int peerId, x, y;
+        TextDecodePosition(encoded[i], peerId, x, y);
+        g_sink += x + y;
+        // the old send path also put the terminating zero on the wire
+        textBytes += encoded[i].size() + 1;
+    }
+    double textDecode = NanosecondsPerIteration(start);
+
+    // binary, the server knows where the player was and only needs the
+    // direction
+    size_t binaryBytes = 0;
+    std::vector<uint8_t> buffers(ITERATIONS * 8);
+    std::vector<size_t> lengths(ITERATIONS);
+    start = Clock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        Protocol::Input input;
+        input.sequence = static_cast<uint32_t>(i + 1);
+        input.direction = static_cast<Protocol::Direction>(i % 4);
+        lengths[i] = Protocol::EncodeInputs(&input, 1, &buffers[i * 8], 8);
+    }
+    double binaryEncode = NanosecondsPerIteration(start);
+
+    start = Clock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        Protocol::Input inputs[Protocol::MAX_INPUTS_PER_MESSAGE];
+        size_t count = 0;
+        if (!Protocol::DecodeInputs(&buffers[i * 8], lengths[i], inputs, count) || count != 1
+            || inputs[0].sequence != static_cast<uint32_t>(i + 1) || inputs[0].direction != static_cast<Protocol::Direction>(i % 4))
+        {
+            std::cout << "  binary input round trip failed" << std::endl;
+            exit(1);
+        }
+        g_sink += static_cast<int>(inputs[0].direction);
+        binaryBytes += lengths[i];
+    }
+    double binaryDecode = NanosecondsPerIteration(start);
+
+    Report("text  ", textEncode, textDecode, textBytes / ITERATIONS);
+    Report("binary", binaryEncode, binaryDecode, binaryBytes / ITERATIONS);
+}
+
+void CheckSnapshot(const Protocol::Snapshot& decoded, const Protocol::Snapshot& expected)
+{
+    bool matches = decoded.roomId == expected.roomId && decoded.sequence == expected.sequence && decoded.players.size() == expected.players.size();
+    for (size_t i = 0; matches && i < expected.players.size(); ++i)
+    {
+        matches = decoded.players[i].peerId == expected.players[i].peerId
+            && decoded.players[i].x == expected.players[i].x && decoded.players[i].y == expected.players[i].y;
+    }
+
+    if (!matches)
+    {
+        std::cout << "  binary snapshot round trip failed" << std::endl;
+        exit(1);
+    }
+}
+
+void BenchSnapshot()
+{
+    std::cout << "Snapshot of " << SNAPSHOT_PLAYERS << " players" << std::endl;
+
+    auto players = MakePlayers(SNAPSHOT_PLAYERS);
+    auto bits = Protocol::CoordinateBits::ForLevel(LEVEL_WIDTH, LEVEL_HEIGHT);
+    std::vector<Protocol::PlayerPosition> decoded;
+
+    Protocol::Snapshot snapshot;
+    snapshot.roomId = 0;
+    snapshot.sequence = 1;
+    snapshot.players = players;
+    Protocol::Snapshot decodedSnapshot;
+
+    // text
+    std::string text;
+    auto start = Clock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        text = TextEncodeSnapshot(players);
+        g_sink += static_cast<int>(text.size());
+    }
+    double textEncode = NanosecondsPerIteration(start);
+
+    start = Clock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        TextDecodeSnapshot(text, decoded);
+        g_sink += static_cast<int>(decoded.size());
+    }
+    double textDecode = NanosecondsPerIteration(start);
+
+    // binary
+    uint8_t buffer[Protocol::MAX_MESSAGE_SIZE];
+    size_t length = 0;
+    start = Clock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        length = Protocol::EncodeSnapshot(snapshot, nullptr, bits, buffer, sizeof(buffer));
+        g_sink += static_cast<int>(length);
+    }
+    double binaryEncode = NanosecondsPerIteration(start);
+
+    start = Clock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        Protocol::DecodeSnapshot(buffer, length, nullptr, decodedSnapshot);
+        g_sink += static_cast<int>(decodedSnapshot.players.size());
+    }
+    double binaryDecode = NanosecondsPerIteration(start);
+
+    CheckSnapshot(decodedSnapshot, snapshot);
+
+    Report("text  ", textEncode, textDecode, text.size() + 1);
+    Report("binary", binaryEncode, binaryDecode, length);
+}
+
+void BenchDeltaSnapshot()
+{
+    std::cout << "Delta snapshot of " << SNAPSHOT_PLAYERS << " players, " << DELTA_MOVED_PLAYERS << " moved" << std::endl;
+
+    auto bits = Protocol::CoordinateBits::ForLevel(LEVEL_WIDTH, LEVEL_HEIGHT);
+
+    Protocol::Snapshot baseline;
+    baseline.roomId = 0;
+    baseline.sequence = 1;
+    baseline.players = MakePlayers(SNAPSHOT_PLAYERS);
+
+    Protocol::Snapshot snapshot = baseline;
+    snapshot.sequence = 2;
+    for (int i = 0; i < DELTA_MOVED_PLAYERS; ++i)
+    {
+        Protocol::PlayerPosition& player = snapshot.players[rand() % snapshot.players.size()];
+        player.x = (player.x + 1) % LEVEL_WIDTH;
+    }
+    Protocol::Snapshot decodedSnapshot;
+
+    uint8_t buffer[Protocol::MAX_MESSAGE_SIZE];
+    size_t length = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        length = Protocol::EncodeSnapshot(snapshot, &baseline, bits, buffer, sizeof(buffer));
+        g_sink += static_cast<int>(length);
+    }
+    double encode = NanosecondsPerIteration(start);
+
+    start = Clock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        Protocol::DecodeSnapshot(buffer, length, &baseline, decodedSnapshot);
+        g_sink += static_cast<int>(decodedSnapshot.players.size());
+    }
+    double decode = NanosecondsPerIteration(start);
+
+    CheckSnapshot(decodedSnapshot, snapshot);
+
+    Report("delta ", encode, decode, length);
+}
+
+// lays message out the way it leaves a host: an ENet send unreliable command
+// followed by the batch frame SendQueue puts around it. ENet's protocol
+// header isn't compressed, so it isn't there
+size_t MakeDatagram(const uint8_t* message, size_t length, uint16_t sequence, uint8_t* datagram)
+{
+    size_t frameLength = length + 2;
+    size_t size = 0;
+    datagram[size++] = ENET_PROTOCOL_COMMAND_SEND_UNRELIABLE;
+    datagram[size++] = UNRELIABLE_CHANNEL;
+    // reliable sequence number of the channel, nothing reliable sent yet
+    datagram[size++] = 0;
+    datagram[size++] = 0;
+    datagram[size++] = static_cast<uint8_t>(sequence >> 8);
+    datagram[size++] = static_cast<uint8_t>(sequence);
+    datagram[size++] = static_cast<uint8_t>(frameLength >> 8);
+    datagram[size++] = static_cast<uint8_t>(frameLength);
+    // padded two byte varint, as reserved for any message up to MAX_BATCH_SIZE
+    datagram[size++] = static_cast<uint8_t>((length & 0x7F) | 0x80);
+    datagram[size++] = static_cast<uint8_t>(length >> 7);
+    memcpy(datagram + size, message, length);
+    return size + length;
+}
+
+void BenchCompressor(const char* name, const ENetCompressor& compressor, const uint8_t* datagram, size_t length)
+{
+    ENetBuffer buffer;
+    buffer.data = const_cast<uint8_t*>(datagram);
+    buffer.dataLength = length;
+
+    // ENet never lets a compressor grow a datagram
+    uint8_t compressed[ENET_PROTOCOL_MAXIMUM_MTU];
+    size_t compressedLength = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        compressedLength = compressor.compress(compressor.context, &buffer, 1, length, compressed, length);
+        g_sink += static_cast<int>(compressedLength);
+    }
+    double compress = NanosecondsPerIteration(start);
+
+    if (compressedLength == 0 || compressedLength >= length)
+    {
+        std::cout << "  " << name << ": compress " << compress << " ns, doesn't get smaller, sent as is" << std::endl;
+        return;
+    }
+
+    uint8_t decompressed[ENET_PROTOCOL_MAXIMUM_MTU];
+    size_t decompressedLength = 0;
+    start = Clock::now();
+    for (int i = 0; i < ITERATIONS; ++i)
+    {
+        decompressedLength = compressor.decompress(compressor.context, compressed, compressedLength, decompressed, sizeof(decompressed));
+        g_sink += static_cast<int>(decompressedLength);
+    }
+    double decompress = NanosecondsPerIteration(start);
+
+    if (decompressedLength != length || memcmp(decompressed, datagram, length) != 0)
+    {
+        std::cout << "  " << name << " round trip failed" << std::endl;
+        exit(1);
+    }
+
+    std::cout << "  " << name << ": compress " << compress << " ns, decompress " << decompress << " ns, "
+        << compressedLength << " bytes, ratio " << static_cast<double>(compressedLength) / length << std::endl;
+}
+
+void BenchCompression()
+{
+    auto bits = Protocol::CoordinateBits::ForLevel(LEVEL_WIDTH, LEVEL_HEIGHT);
+
+    Protocol::Snapshot baseline;
+    baseline.roomId = 0;
+    baseline.sequence = 1200;
+    baseline.serverTime = 20000;
+    baseline.players = MakePlayers(SNAPSHOT_PLAYERS);
+    baseline.hasSelf = true;
+    baseline.selfX = LEVEL_WIDTH / 2;
+    baseline.selfY = LEVEL_HEIGHT / 2;
+    baseline.inputSequence = 150;
+
+    Protocol::Snapshot snapshot = baseline;
+    snapshot.sequence++;
+    snapshot.serverTime += 16;
+    for (int i = 0; i < DELTA_MOVED_PLAYERS; ++i)
+    {
+        Protocol::PlayerPosition& player = snapshot.players[rand() % snapshot.players.size()];
+        player.x = (player.x + 1) % LEVEL_WIDTH;
+    }
+
+    Protocol::Input inputs[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        inputs[i].sequence = 151 + i;
+        inputs[i].direction = static_cast<Protocol::Direction>(i % 4);
+    }
+
+    struct Case
+    {
+        const char* name;
+        uint8_t message[Protocol::MAX_MESSAGE_SIZE];
+        size_t length;
+    };
+    Case cases[4];
+    cases[0].name = "Full snapshot";
+    cases[0].length = Protocol::EncodeSnapshot(baseline, nullptr, bits, cases[0].message, sizeof(cases[0].message));
+    cases[1].name = "Delta snapshot";
+    cases[1].length = Protocol::EncodeSnapshot(snapshot, &baseline, bits, cases[1].message, sizeof(cases[1].message));
+    cases[2].name = "Input of 3 steps";
+    cases[2].length = Protocol::EncodeInputs(inputs, 3, cases[2].message, sizeof(cases[2].message));
+    cases[3].name = "Snapshot ack";
+    cases[3].length = Protocol::EncodeSnapshotAck(snapshot.sequence, cases[3].message, sizeof(cases[3].message));
+
+    // as enet_host_compress_with_range_coder() sets it up
+    ENetCompressor rangeCoder;
+    rangeCoder.context = enet_range_coder_create();
+    rangeCoder.compress = enet_range_coder_compress;
+    rangeCoder.decompress = enet_range_coder_decompress;
+    rangeCoder.destroy = enet_range_coder_destroy;
+
+    ENetCompressor zeroPack;
+    zeroPack.context = &zeroPack;
+    zeroPack.compress = PacketCompression::ZeroPack;
+    zeroPack.decompress = PacketCompression::ZeroUnpack;
+    zeroPack.destroy = nullptr;
+
+    for (const auto& testCase : cases)
+    {
+        uint8_t datagram[ENET_PROTOCOL_MAXIMUM_MTU];
+        size_t length = MakeDatagram(testCase.message, testCase.length, 1200, datagram);
+        std::cout << testCase.name << " datagram, " << length << " bytes" << std::endl;
+        BenchCompressor("range   ", rangeCoder, datagram, length);
+        BenchCompressor("zeropack", zeroPack, datagram, length);
+    }
+
+    rangeCoder.destroy(rangeCoder.context);
+}
+
+int main()
+{
+    BenchStep();
+    BenchSnapshot();
+    BenchDeltaSnapshot();
+    BenchCompression();
+    BenchRender();
+    return 0;
+}
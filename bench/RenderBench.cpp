@@ -0,0 +1,142 @@
+#include "RenderBench.h"
+
+#include "Level.h"
+#include "LevelView.h"
+#include "NullTerminal.h"
+#include "Player.h"
+#include "Renderer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// Draws a large level with moving enemies and a walking player through
+// Renderer and LevelView into a NullTerminal, the way GameplayState draws
+// a frame. Reports the cells written, cursor moves and color changes a
+// frame hands the terminal and the time it takes, once with only the cells
+// that changed written and once with every frame drawn whole
+
+const int RENDER_WIDTH = 200;
+const int RENDER_HEIGHT = 60;
+const int RENDER_FRAMES = 2000;
+const char* RENDER_LEVEL_FILE_NAME = "RenderBench.txt";
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// walls around, pillars every few tiles, and keys, doors, money and
+// enemies scattered between them
+std::string MakeLevelFile()
+{
+    std::string tiles;
+    for (int y = 0; y < RENDER_HEIGHT; ++y)
+    {
+        for (int x = 0; x < RENDER_WIDTH; ++x)
+        {
+            bool corner = (x == 0 || x == RENDER_WIDTH - 1) && (y == 0 || y == RENDER_HEIGHT - 1);
+            char tile = ' ';
+            if (corner || (x % 8 == 4 && y % 6 == 3))
+            {
+                tile = '+';
+            }
+            else if (y == 0 || y == RENDER_HEIGHT - 1)
+            {
+                tile = '-';
+            }
+            else if (x == 0 || x == RENDER_WIDTH - 1)
+            {
+                tile = '|';
+            }
+            else if (x == 1 && y == 1)
+            {
+                tile = '@';
+            }
+            else if (x % 16 == 8 && y % 6 == 0)
+            {
+                tile = "hve"[(x / 16 + y / 6) % 3];
+            }
+            else if (x % 24 == 12 && y % 12 == 9)
+            {
+                tile = "$rRgGbB"[(x / 24 + y / 12) % 7];
+            }
+            tiles += tile;
+        }
+    }
+
+    // rows follow each other without line breaks
+    return std::to_string(RENDER_WIDTH) + "\n" + std::to_string(RENDER_HEIGHT) + "\n" + tiles;
+}
+
+void BenchRenderFrames(const char* name, Level& level, bool fullRedraw)
+{
+    NullTerminal terminal(RENDER_WIDTH, RENDER_HEIGHT);
+    Renderer& renderer = Renderer::GetInstance();
+    renderer.SetTerminal(&terminal);
+
+    Player player(true);
+    player.SetPosition(level.GetSpawnX(), level.GetSpawnY());
+    int directionX = 1;
+
+    // the first frame is drawn whole either way
+    renderer.BeginFrame();
+    LevelView::Draw(level);
+    renderer.Present();
+    size_t written = terminal.GetWrittenCount();
+    size_t moves = terminal.GetMoveCount();
+    size_t colorChanges = terminal.GetColorChangeCount();
+
+    auto start = Clock::now();
+    for (int frame = 0; frame < RENDER_FRAMES; ++frame)
+    {
+        // walk back and forth along the top row
+        int x = player.GetXPosition() + directionX;
+        if (level.IsWall(x, player.GetYPosition()))
+        {
+            directionX = -directionX;
+            x = player.GetXPosition() + directionX;
+        }
+        player.SetPosition(x, player.GetYPosition());
+        level.UpdateActors(player.GetXPosition(), player.GetYPosition());
+
+        if (fullRedraw)
+        {
+            renderer.Invalidate();
+        }
+        renderer.BeginFrame();
+        LevelView::Draw(level);
+        LevelView::DrawActor(player, player.GetXPosition(), player.GetYPosition());
+        renderer.Present();
+    }
+    double frameUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / RENDER_FRAMES;
+
+    std::cout << "  " << name << ": " << frameUs << " us, "
+        << static_cast<double>(terminal.GetWrittenCount() - written) / RENDER_FRAMES << " cells written, "
+        << static_cast<double>(terminal.GetMoveCount() - moves) / RENDER_FRAMES << " cursor moves, "
+        << static_cast<double>(terminal.GetColorChangeCount() - colorChanges) / RENDER_FRAMES << " color changes per frame"
+        << std::endl;
+
+    renderer.SetTerminal(nullptr);
+}
+
+void BenchRender()
+{
+    {
+        std::ofstream levelFile(RENDER_LEVEL_FILE_NAME);
+        levelFile << MakeLevelFile();
+    }
+
+    Level level;
+    bool loaded = level.Load(RENDER_LEVEL_FILE_NAME, nullptr, nullptr);
+    remove(RENDER_LEVEL_FILE_NAME);
+    if (!loaded)
+    {
+        std::cout << "Couldn't load the render benchmark's level" << std::endl;
+        return;
+    }
+
+    std::cout << "Rendering a " << RENDER_WIDTH << "x" << RENDER_HEIGHT << " level with " << level.GetActors().size()
+        << " actors, " << RENDER_WIDTH * RENDER_HEIGHT << " cells" << std::endl;
+    BenchRenderFrames("changed cells", level, false);
+    BenchRenderFrames("whole frames ", level, true);
+}
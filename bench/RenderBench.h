@@ -0,0 +1,5 @@
+#pragma once
+
+// draws a level through the game's renderer into a terminal that shows
+// nothing, and prints what each frame hands the terminal
+void BenchRender();
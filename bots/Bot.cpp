@@ -0,0 +1,213 @@
+#include "Bot.h"
+
+#include "Protocol.h"
+
+// chance in 1/n to turn at a crossing instead of walking on
+const uint32_t TURN_CHANCE = 4;
+// same as the game, unacknowledged steps are sent again this often
+const auto INPUT_RESEND_INTERVAL = std::chrono::milliseconds(50);
+
+const Protocol::Direction DIRECTIONS[] = {
+    Protocol::Direction::LEFT, Protocol::Direction::RIGHT, Protocol::Direction::UP, Protocol::Direction::DOWN
+};
+
+Bot::Bot(uint32_t seed, const Level& level, uint32_t roomId, Clock::duration moveInterval)
+    : m_level(level)
+    , m_roomId(roomId)
+    , m_x(level.GetSpawnX())
+    , m_y(level.GetSpawnY())
+    , m_walking(false)
+    , m_direction(Protocol::Direction::LEFT)
+    , m_random(seed)
+    , m_moveInterval(moveInterval)
+    , m_nextMove(Clock::now())
+{
+    m_snapshots.Reset(roomId);
+}
+
+bool Bot::Connect(const std::string& host, uint32_t port, uint32_t incomingBandwidth, PacketCompression::Type compression)
+{
+    m_client.SetBandwidthLimit(incomingBandwidth, 0);
+    if (!m_client.SetCompression(compression))
+    {
+        return false;
+    }
+    // the room is joined once the connection is up, see Join()
+    return !m_client.Connect(host, port);
+}
+
+void Bot::Join()
+{
+    // the room puts us at its spawn
+    m_x = m_level.GetSpawnX();
+    m_y = m_level.GetSpawnY();
+    m_walking = false;
+    uint32_t joinSequence = m_predictor.Restart();
+    uint8_t* buffer = m_client.BeginSend(DeliveryType::RELIABLE, Protocol::GetMaxJoinSize());
+    if (buffer != nullptr)
+    {
+        m_client.CommitSend(Protocol::EncodeJoin(m_roomId, joinSequence, buffer, Protocol::GetMaxJoinSize()));
+    }
+
+    // spread the first steps over a move interval so bots don't move in
+    // lockstep
+    m_nextMove = Clock::now() + m_moveInterval * (m_random() % 1000) / 1000;
+}
+
+void Bot::Disconnect()
+{
+    m_client.Disconnect();
+}
+
+bool Bot::IsConnected() const
+{
+    return m_client.IsConnected();
+}
+
+bool Bot::HasFailed() const
+{
+    return m_client.GetState() == ENetClient::State::FAILED;
+}
+
+void Bot::Update(Clock::time_point now)
+{
+    // also carries on connecting
+    ProcessMessages();
+    if (!m_client.IsConnected())
+    {
+        return;
+    }
+
+    if (now >= m_nextMove)
+    {
+        m_nextMove += m_moveInterval;
+        Move();
+    }
+
+    if (m_predictor.GetPendingCount() > 0 && now - m_lastInputSent >= INPUT_RESEND_INTERVAL)
+    {
+        SendPendingInputs(now);
+    }
+
+    m_client.Flush();
+}
+
+const BotStats& Bot::GetStats() const
+{
+    return m_stats;
+}
+
+void Bot::ResetStats()
+{
+    m_stats = BotStats();
+}
+
+uint32_t Bot::GetRoundTripTime() const
+{
+    return m_client.GetRoundTripTime();
+}
+
+float Bot::GetPacketLoss() const
+{
+    return m_client.GetPacketLoss();
+}
+
+void Bot::ProcessMessages()
+{
+    for (const auto& msg : m_client.Poll())
+    {
+        if (msg.GetType() == Message::Type::CONNECT)
+        {
+            Join();
+            continue;
+        }
+        if (msg.GetType() == Message::Type::DISCONNECT)
+        {
+            // the next connection numbers its snapshots from the start
+            m_snapshots.Reset(m_roomId);
+            continue;
+        }
+
+        m_stats.bytesReceived += msg.GetDataLength();
+
+        uint32_t lastSequence = m_snapshots.GetLastSequence();
+        if (!m_snapshots.Receive(msg.GetData(), msg.GetDataLength()))
+        {
+            m_stats.snapshotsDropped++;
+            continue;
+        }
+
+        m_stats.snapshotsReceived++;
+        if (lastSequence != Protocol::NO_BASELINE)
+        {
+            m_stats.snapshotsLost += m_snapshots.GetLastSequence() - lastSequence - 1;
+        }
+
+        uint8_t* buffer = m_client.BeginSend(DeliveryType::UNRELIABLE, Protocol::GetMaxSnapshotAckSize());
+        if (buffer != nullptr)
+        {
+            m_client.CommitSend(Protocol::EncodeSnapshotAck(m_snapshots.GetLastSequence(), buffer, Protocol::GetMaxSnapshotAckSize()));
+        }
+
+        // the same correction the game makes
+        const Level& level = m_level;
+        auto isWall = [&level](int x, int y) { return level.IsWall(x, y); };
+        m_predictor.Reconcile(m_snapshots.GetSnapshot(), isWall, m_x, m_y);
+    }
+}
+
+void Bot::Move()
+{
+    // walk down corridors, turning now and then and whenever blocked. Bots
+    // never carry keys, so doors block them like walls
+    int x = m_x;
+    int y = m_y;
+    Protocol::Step(m_direction, x, y);
+    if (!m_walking || m_level.IsBlocked(x, y) || m_random() % TURN_CHANCE == 0)
+    {
+        Protocol::Direction open[4];
+        int openCount = 0;
+        for (auto direction : DIRECTIONS)
+        {
+            x = m_x;
+            y = m_y;
+            Protocol::Step(direction, x, y);
+            if (!m_level.IsBlocked(x, y))
+            {
+                open[openCount++] = direction;
+            }
+        }
+        if (openCount == 0)
+        {
+            // walled in
+            return;
+        }
+
+        m_direction = open[m_random() % openCount];
+        m_walking = true;
+    }
+
+    Protocol::Step(m_direction, m_x, m_y);
+    SendInput(m_direction);
+}
+
+void Bot::SendInput(Protocol::Direction direction)
+{
+    m_predictor.Push(direction);
+    m_stats.inputsSent++;
+    SendPendingInputs(Clock::now());
+}
+
+void Bot::SendPendingInputs(Clock::time_point now)
+{
+    // the same message the game sends after every step
+    Protocol::Input inputs[Protocol::MAX_INPUTS_PER_MESSAGE];
+    size_t count = m_predictor.GetPending(inputs, Protocol::MAX_INPUTS_PER_MESSAGE);
+    uint8_t* buffer = m_client.BeginSend(DeliveryType::UNRELIABLE, Protocol::GetMaxInputSize());
+    if (buffer != nullptr)
+    {
+        m_client.CommitSend(Protocol::EncodeInputs(inputs, count, buffer, Protocol::GetMaxInputSize()));
+        m_stats.inputMessagesSent++;
+    }
+    m_lastInputSent = now;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "ENetClient.h"
+#include "Level.h"
+#include "MovePredictor.h"
+#include "SnapshotReceiver.h"
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+
+struct BotStats
+{
+    uint64_t snapshotsReceived = 0;
+    // never arrived, told by gaps in the sequence numbers since the server
+    // only numbers snapshots it actually sends
+    uint64_t snapshotsLost = 0;
+    // arrived but couldn't be used: late, or their baseline was gone
+    uint64_t snapshotsDropped = 0;
+    uint64_t bytesReceived = 0;
+    uint64_t inputsSent = 0;
+    // INPUT messages, each repeats every step not acknowledged yet
+    uint64_t inputMessagesSent = 0;
+};
+
+// One simulated player: joins a room, walks the level following the game's
+// movement rules and acknowledges the snapshots it receives, all through
+// the same ENetClient and protocol code the game uses
+class Bot
+{
+
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    Bot(uint32_t seed, const Level& level, uint32_t roomId, Clock::duration moveInterval);
+
+    // only starts connecting, Update() carries it on and joins the room
+    // once connected. incomingBandwidth in bytes per second, 0 for any
+    // amount
+    bool Connect(const std::string& host, uint32_t port, uint32_t incomingBandwidth = 0,
+        PacketCompression::Type compression = PacketCompression::Type::NONE);
+    void Disconnect();
+    bool IsConnected() const;
+    // gave up connecting
+    bool HasFailed() const;
+
+    // handles everything received, takes a step if one is due and sends
+    // what that queued
+    void Update(Clock::time_point now);
+
+    const BotStats& GetStats() const;
+    void ResetStats();
+
+    uint32_t GetRoundTripTime() const;
+    float GetPacketLoss() const;
+
+private:
+    void Join();
+    void ProcessMessages();
+    void Move();
+    void SendInput(Protocol::Direction direction);
+    void SendPendingInputs(Clock::time_point now);
+
+    ENetClient m_client;
+
+    const Level& m_level;
+    uint32_t m_roomId;
+
+    int m_x;
+    int m_y;
+    bool m_walking;
+    Protocol::Direction m_direction;
+    MovePredictor m_predictor;
+    Clock::time_point m_lastInputSent;
+
+    std::mt19937 m_random;
+    Clock::duration m_moveInterval;
+    Clock::time_point m_nextMove;
+
+    SnapshotReceiver m_snapshots;
+    BotStats m_stats;
+};
@@ -0,0 +1,332 @@
+#include "Bot.h"
+#include "Level.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+const char* DEFAULT_HOST = "localhost";
+const uint32_t PORT = 7000;
+const uint32_t DEFAULT_BOTS = 100;
+const char* DEFAULT_LEVEL_DIRECTORY = ".";
+// tiles per second, about as fast as someone holding down a key
+const uint32_t DEFAULT_MOVE_RATE = 10;
+const uint32_t MAX_MOVE_RATE = 1000;
+const uint32_t DEFAULT_DURATION_S = 30;
+const auto REPORT_INTERVAL = std::chrono::seconds(1);
+
+std::atomic<bool> quit(false);
+
+struct BotOptions
+{
+    std::string host = DEFAULT_HOST;
+    uint32_t port = PORT;
+    // bots are spread over the server's ports like players would be
+    uint32_t shards = 1;
+    uint32_t bots = DEFAULT_BOTS;
+    // every room plays its own level, like on the server
+    std::string levelDirectory = DEFAULT_LEVEL_DIRECTORY;
+    // bots are spread over this many rooms, starting at firstRoom
+    uint32_t rooms = 1;
+    uint32_t firstRoom = 0;
+    uint32_t moveRate = DEFAULT_MOVE_RATE;
+    // 0 runs until interrupted
+    uint32_t duration = DEFAULT_DURATION_S;
+    // kilobytes per second each bot takes in, to play weak links. 0 takes
+    // any amount
+    uint32_t bandwidth = 0;
+    // has to be the server's
+    PacketCompression::Type compression = PacketCompression::Type::NONE;
+};
+
+void PrintUsage()
+{
+    std::cout << "Usage: mazebots [--host ADDRESS] [--port N] [--shards N] [--bots N] [--levels DIR]"
+        << " [--rooms N] [--first-room N] [--move-rate TILES_PER_S] [--duration S] [--bandwidth KBPS]"
+        << " [--compression none|range|zeropack]" << std::endl;
+}
+
+// every option takes a value, returns false on anything it doesn't know
+bool ParseOptions(int argc, char** argv, BotOptions& options)
+{
+    for (int i = 1; i < argc; i += 2)
+    {
+        if (i + 1 >= argc)
+        {
+            return false;
+        }
+
+        const char* name = argv[i];
+        const char* value = argv[i + 1];
+        if (strcmp(name, "--host") == 0)
+        {
+            options.host = value;
+        }
+        else if (strcmp(name, "--port") == 0)
+        {
+            options.port = static_cast<uint32_t>(atoi(value));
+        }
+        else if (strcmp(name, "--shards") == 0)
+        {
+            options.shards = static_cast<uint32_t>(atoi(value));
+        }
+        else if (strcmp(name, "--bots") == 0)
+        {
+            options.bots = static_cast<uint32_t>(atoi(value));
+        }
+        else if (strcmp(name, "--levels") == 0)
+        {
+            options.levelDirectory = value;
+        }
+        else if (strcmp(name, "--rooms") == 0)
+        {
+            options.rooms = static_cast<uint32_t>(atoi(value));
+        }
+        else if (strcmp(name, "--first-room") == 0)
+        {
+            options.firstRoom = static_cast<uint32_t>(atoi(value));
+        }
+        else if (strcmp(name, "--move-rate") == 0)
+        {
+            options.moveRate = static_cast<uint32_t>(atoi(value));
+        }
+        else if (strcmp(name, "--duration") == 0)
+        {
+            options.duration = static_cast<uint32_t>(atoi(value));
+        }
+        else if (strcmp(name, "--bandwidth") == 0)
+        {
+            options.bandwidth = static_cast<uint32_t>(atoi(value));
+        }
+        else if (strcmp(name, "--compression") == 0)
+        {
+            if (!PacketCompression::Parse(value, options.compression))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void OnInterrupt(int)
+{
+    quit = true;
+}
+
+// nearest rank, values must be sorted
+uint32_t Percentile(const std::vector<uint32_t>& values, uint32_t percent)
+{
+    if (values.empty())
+    {
+        return 0;
+    }
+    size_t rank = (values.size() * percent + 99) / 100;
+    return values[rank == 0 ? 0 : rank - 1];
+}
+
+double Percent(uint64_t part, uint64_t whole)
+{
+    return whole == 0 ? 0.0 : 100.0 * part / whole;
+}
+
+// totals every bot's counters since the last report, then starts them over
+void Report(std::vector<std::unique_ptr<Bot>>& bots, double seconds, BotStats& runTotal)
+{
+    BotStats total;
+    std::vector<uint32_t> roundTripTimes;
+    roundTripTimes.reserve(bots.size());
+    float packetLoss = 0.0f;
+    size_t connected = 0;
+
+    for (auto& bot : bots)
+    {
+        const BotStats& stats = bot->GetStats();
+        total.snapshotsReceived += stats.snapshotsReceived;
+        total.snapshotsLost += stats.snapshotsLost;
+        total.snapshotsDropped += stats.snapshotsDropped;
+        total.bytesReceived += stats.bytesReceived;
+        total.inputsSent += stats.inputsSent;
+        total.inputMessagesSent += stats.inputMessagesSent;
+        bot->ResetStats();
+
+        if (bot->IsConnected())
+        {
+            connected++;
+            roundTripTimes.push_back(bot->GetRoundTripTime());
+            packetLoss += bot->GetPacketLoss();
+        }
+    }
+    std::sort(roundTripTimes.begin(), roundTripTimes.end());
+
+    runTotal.snapshotsReceived += total.snapshotsReceived;
+    runTotal.snapshotsLost += total.snapshotsLost;
+    runTotal.snapshotsDropped += total.snapshotsDropped;
+    runTotal.bytesReceived += total.bytesReceived;
+    runTotal.inputsSent += total.inputsSent;
+    runTotal.inputMessagesSent += total.inputMessagesSent;
+
+    uint64_t expected = total.snapshotsReceived + total.snapshotsLost;
+    std::cout << std::fixed << std::setprecision(1)
+        << connected << "/" << bots.size() << " bots | "
+        << total.snapshotsReceived / seconds << " snapshots/s, "
+        << total.bytesReceived / 1024.0 / seconds << " KB/s in, "
+        << total.inputsSent / seconds << " moves/s in "
+        << total.inputMessagesSent / seconds << " input messages/s | rtt p50 "
+        << Percentile(roundTripTimes, 50) << " p90 " << Percentile(roundTripTimes, 90)
+        << " p99 " << Percentile(roundTripTimes, 99) << " ms | loss enet "
+        << (connected == 0 ? 0.0 : 100.0 * packetLoss / connected) << "%, snapshots "
+        << Percent(total.snapshotsLost, expected) << "% lost "
+        << Percent(total.snapshotsDropped, expected) << "% dropped" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    BotOptions options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    if (options.bots == 0 || options.shards == 0 || options.rooms == 0)
+    {
+        std::cout << "Bots, shards and rooms have to be at least 1" << std::endl;
+        return 1;
+    }
+
+    if (options.moveRate == 0 || options.moveRate > MAX_MOVE_RATE)
+    {
+        std::cout << "Invalid move rate " << options.moveRate << ", expected 1-" << MAX_MOVE_RATE << std::endl;
+        return 1;
+    }
+
+    std::map<uint32_t, std::unique_ptr<Level>> levels;
+    for (uint32_t i = 0; i < options.rooms; ++i)
+    {
+        uint32_t roomId = options.firstRoom + i;
+        std::string fileName = options.levelDirectory + "/" + Level::GetFileName(roomId);
+        levels[roomId].reset(new Level());
+        if (!levels[roomId]->Load(fileName, nullptr, nullptr))
+        {
+            std::cout << "Couldn't load level " << fileName << " of room " << roomId << std::endl;
+            return 1;
+        }
+    }
+
+    signal(SIGINT, OnInterrupt);
+
+    auto moveInterval = std::chrono::duration_cast<Bot::Clock::duration>(std::chrono::seconds(1)) / options.moveRate;
+
+    std::vector<std::unique_ptr<Bot>> bots;
+    bots.reserve(options.bots);
+    for (uint32_t i = 0; i < options.bots && !quit; ++i)
+    {
+        uint32_t roomId = options.firstRoom + i % options.rooms;
+        uint32_t port = options.port + i % options.shards;
+
+        std::unique_ptr<Bot> bot(new Bot(i, *levels.at(roomId), roomId, moveInterval));
+        if (!bot->Connect(options.host, port, options.bandwidth * 1000, options.compression))
+        {
+            std::cout << "Bot " << i << " couldn't connect to " << options.host << ":" << port << std::endl;
+            continue;
+        }
+        bots.push_back(std::move(bot));
+    }
+
+    // all of them connect at once, the ones already in keep going while
+    // the rest retry
+    while (!quit)
+    {
+        size_t pending = 0;
+        for (auto& bot : bots)
+        {
+            bot->Update(Bot::Clock::now());
+            pending += !bot->IsConnected() && !bot->HasFailed() ? 1 : 0;
+        }
+        if (pending == 0)
+        {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    size_t failed = 0;
+    for (auto iter = bots.begin(); iter != bots.end();)
+    {
+        if ((*iter)->IsConnected())
+        {
+            ++iter;
+            continue;
+        }
+        failed++;
+        iter = bots.erase(iter);
+    }
+    if (failed > 0)
+    {
+        std::cout << failed << " bots couldn't connect to " << options.host << std::endl;
+    }
+
+    if (bots.empty())
+    {
+        return 1;
+    }
+
+    std::cout << bots.size() << " bots in " << options.rooms << " rooms on " << options.host << " ports " << options.port
+        << "-" << options.port + options.shards - 1 << ", moving " << options.moveRate << " tiles/s" << std::endl;
+
+    // counters from connecting aren't part of the run
+    for (auto& bot : bots)
+    {
+        bot->ResetStats();
+    }
+
+    BotStats runTotal;
+    auto start = Bot::Clock::now();
+    auto end = start + std::chrono::seconds(options.duration);
+    auto lastReport = start;
+
+    while (!quit && (options.duration == 0 || Bot::Clock::now() < end))
+    {
+        auto now = Bot::Clock::now();
+        for (auto& bot : bots)
+        {
+            bot->Update(now);
+        }
+
+        if (now - lastReport >= REPORT_INTERVAL)
+        {
+            Report(bots, std::chrono::duration<double>(now - lastReport).count(), runTotal);
+            lastReport = now;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    Report(bots, std::chrono::duration<double>(Bot::Clock::now() - lastReport).count(), runTotal);
+
+    double seconds = std::chrono::duration<double>(Bot::Clock::now() - start).count();
+    uint64_t expected = runTotal.snapshotsReceived + runTotal.snapshotsLost;
+    std::cout << std::fixed << std::setprecision(1) << "Total over " << seconds << " s: "
+        << runTotal.snapshotsReceived << " snapshots, " << runTotal.bytesReceived / 1024.0 << " KB in, "
+        << runTotal.inputsSent << " moves, " << Percent(runTotal.snapshotsLost, expected) << "% snapshots lost" << std::endl;
+
+    for (auto& bot : bots)
+    {
+        bot->Disconnect();
+    }
+}
@@ -1,5 +1,5 @@
 #include "Enemy.h"
-#include <iostream>
+#include <cstdlib>
 
 Enemy::Enemy(int x, int y, int deltaX, int deltaY)
 	: PlacableActor(x, y)
@@ -20,11 +20,6 @@ Enemy::Enemy(int x, int y, int deltaX, int deltaY)
 	}
 }
 
-void Enemy::Draw()
-{
-	std::cout << (char)153;
-}
-
 void Enemy::Update()
 {
 	if (m_movementInX != 0)
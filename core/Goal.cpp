@@ -1,4 +1,3 @@
-#include <iostream>
 #include "Goal.h"
 
 Goal::Goal(int x, int y)
@@ -6,8 +5,3 @@ Goal::Goal(int x, int y)
 {
 	
 }
-
-void Goal::Draw()
-{
-	std::cout << "X";
-}
@@ -6,6 +6,5 @@ public:
 	Goal(int x, int y);
 
 	virtual ActorType GetType() override { return ActorType::Goal; }
-	virtual void Draw() override;
 };
 
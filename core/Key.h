@@ -10,6 +10,5 @@ public:
 	}
 
 	virtual ActorType GetType() override { return ActorType::Key; }
-	virtual void Draw() override;
 };
 
@@ -1,6 +1,5 @@
-#include <windows.h>
 #include <assert.h>
-#include <iostream>
+#include <cstdlib>
 #include <fstream>
 #include "Level.h"
 #include "Player.h"
@@ -16,6 +15,8 @@ Level::Level()
 	: m_pLevelData(nullptr)
 	, m_height(0)
 	, m_width(0)
+	, m_spawnX(0)
+	, m_spawnY(0)
 {
 
 }
@@ -35,14 +36,18 @@ Level::~Level()
 	}
 }
 
-bool Level::Load(std::string levelName, int* playerX, int* playerY)
+std::string Level::GetFileName(uint32_t roomId)
+{
+	return "Level" + to_string(roomId + 1) + ".txt";
+}
+
+bool Level::Load(const std::string& fileName, int* playerX, int* playerY)
 {
-	levelName.insert(0, "../");
 	ifstream levelFile;
-	levelFile.open(levelName);
+	levelFile.open(fileName);
 	if (!levelFile)
 	{
-		cout << "Opening file failed: " << levelName << endl;
+		m_warnings.push_back("Opening file failed: " + fileName);
 		return false;
 	}
 	else
@@ -58,58 +63,56 @@ bool Level::Load(std::string levelName, int* playerX, int* playerY)
 		levelFile.getline(temp, tempSize, '\n');
 		m_height = atoi(temp);
 
+		if (m_width <= 0 || m_height <= 0)
+		{
+			m_warnings.push_back("Invalid level size in " + fileName);
+			return false;
+		}
+
 		// Read level
 		m_pLevelData = new char[m_width * m_height];
 		levelFile.read(m_pLevelData, (long long)m_width * (long long)m_height);
-		
-		// Convert level
-		bool anyWarnings = ConvertLevel(playerX, playerY);
-		if (anyWarnings)
+		if (levelFile.gcount() != (long long)m_width * (long long)m_height)
 		{
-			cout << "There were some warnings in the level data, see above." << endl;
-			system("pause");
+			m_warnings.push_back("Level file too short: " + fileName);
+			return false;
 		}
+		
+		// Convert level
+		ConvertLevel(playerX, playerY);
 		return true;
 	}
 }
-void Level::Draw()
-{
-	HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
-	SetConsoleTextAttribute(console, (int)ActorColor::Regular);
 
-	// Draw the Level
-	for (int y = 0; y < GetHeight(); ++y)
+bool Level::IsSpace(int x, int y)
+{
+	return m_pLevelData[GetIndexFromCoordinates(x, y)] == ' ';
+}
+bool Level::IsWall(int x, int y) const
+{
+	if (x < 0 || y < 0 || x >= m_width || y >= m_height)
 	{
-		for (int x = 0; x < GetWidth(); ++x)
-		{
-			int indexToPrint = GetIndexFromCoordinates(x, y);
-			cout << m_pLevelData[indexToPrint];
-		}
-		cout << endl;
+		return true;
 	}
+	return m_pLevelData[GetIndexFromCoordinates(x, y)] == WAL;
+}
 
-	COORD actorCursorPosition;
+bool Level::IsBlocked(int x, int y) const
+{
+	if (IsWall(x, y))
+	{
+		return true;
+	}
 
-	// Draw actors
-	for (auto actor = m_pActors.begin(); actor != m_pActors.end(); ++actor)
+	for (PlacableActor* actor : m_pActors)
 	{
-		if ((*actor)->IsActive())
+		if (actor->IsActive() && actor->GetType() == ActorType::Door
+			&& actor->GetXPosition() == x && actor->GetYPosition() == y)
 		{
-			actorCursorPosition.X = (*actor)->GetXPosition();
-			actorCursorPosition.Y = (*actor)->GetYPosition();
-			SetConsoleCursorPosition(console, actorCursorPosition);
-			(*actor)->Draw();
+			return !static_cast<Door*>(actor)->IsOpen();
 		}
 	}
-}
-
-bool Level::IsSpace(int x, int y)
-{
-	return m_pLevelData[GetIndexFromCoordinates(x, y)] == ' ';
-}
-bool Level::IsWall(int x, int y)
-{
-	return m_pLevelData[GetIndexFromCoordinates(x, y)] == WAL;
+	return false;
 }
 
 bool Level::ConvertLevel(int* playerX, int* playerY)
@@ -161,6 +164,8 @@ bool Level::ConvertLevel(int* playerX, int* playerY)
 				break;
 			case '@':
 				m_pLevelData[index] = ' ';
+				m_spawnX = x;
+				m_spawnY = y;
 				if (playerX != nullptr && playerY != nullptr)
 				{
 					*playerX = x;
@@ -184,7 +189,7 @@ bool Level::ConvertLevel(int* playerX, int* playerY)
 			case ' ':
 				break;
 			default:
-				cout << "Invalid character in level file: " << m_pLevelData[index] << endl;
+				m_warnings.push_back(string("Invalid character in level file: ") + m_pLevelData[index]);
 				anyWarnings = true;
 				break;
 			}
@@ -194,7 +199,7 @@ bool Level::ConvertLevel(int* playerX, int* playerY)
 	return anyWarnings;
 }
 
-int Level::GetIndexFromCoordinates(int x, int y)
+int Level::GetIndexFromCoordinates(int x, int y) const
 {
 	return x + y * m_width;
 }
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class PlacableActor;
+
+class Level
+{
+	char* m_pLevelData;
+	int m_height;
+	int m_width;
+	int m_spawnX;
+	int m_spawnY;
+
+	std::vector<PlacableActor*> m_pActors;
+	std::vector<std::string> m_warnings;
+
+public:
+	Level();
+	~Level();
+
+	// owns its tiles and actors
+	Level(const Level&) = delete;
+	Level& operator=(const Level&) = delete;
+
+	// every level is its own room on the server, room 0 plays Level1.txt
+	static std::string GetFileName(uint32_t roomId);
+
+	bool Load(const std::string& fileName, int* playerX, int* playerY);
+	PlacableActor* UpdateActors(int x, int y);
+
+	// what went wrong reading the file, for the game to show
+	const std::vector<std::string>& GetWarnings() { return m_warnings; }
+
+	bool IsSpace(int x, int y);
+	// outside the level counts as wall
+	bool IsWall(int x, int y) const;
+	// walls and closed doors, for players that never carry a key
+	bool IsBlocked(int x, int y) const;
+
+	int GetHeight() { return m_height; }
+	int GetWidth() { return m_width;  }
+	// where '@' is in the file
+	int GetSpawnX() const { return m_spawnX; }
+	int GetSpawnY() const { return m_spawnY; }
+	char GetTile(int x, int y) { return m_pLevelData[GetIndexFromCoordinates(x, y)]; }
+	const std::vector<PlacableActor*>& GetActors() { return m_pActors; }
+
+	static constexpr char WAL = (char)219;
+
+private:
+	bool ConvertLevel(int* playerX, int* playerY);
+	int GetIndexFromCoordinates(int x, int y) const;
+
+};
\ No newline at end of file
@@ -1,4 +1,3 @@
-#include <iostream>
 #include "Money.h"
 
 Money::Money(int x, int y, int worth)
@@ -7,8 +6,3 @@ Money::Money(int x, int y, int worth)
 {
 
 }
-
-void Money::Draw()
-{
-	std::cout << "$";
-}
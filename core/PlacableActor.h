@@ -41,7 +41,6 @@ public:
 	void Place(int x, int y);
 
 	virtual ActorType GetType() = 0;
-	virtual void Draw() = 0;
 	virtual void Update()
 	{
 
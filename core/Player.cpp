@@ -1,10 +1,5 @@
-#include <iostream>
-
 #include "Player.h"
 #include "Key.h"
-#include "AudioManager.h"
-
-using namespace std;
 
 constexpr int kStartingNumberOfLives = 3;
 
@@ -46,13 +41,7 @@ void Player::DropKey()
 {
 	if (m_pCurrentKey)
 	{
-		AudioManager::GetInstance()->PlayKeyDropSound();
 		m_pCurrentKey->Place(m_pPosition->x, m_pPosition->y);
 		m_pCurrentKey = nullptr;
 	}
 }
-
-void Player::Draw()
-{
-	cout << (m_isOwnPlayer ? "@" : "#");
-}
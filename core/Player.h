@@ -21,8 +21,9 @@ public:
 	int GetLives() { return m_lives; }
 	void DecrementLives() { m_lives--; }
 
+	bool IsOwnPlayer() { return m_isOwnPlayer; }
+
 	virtual ActorType GetType() override { return ActorType::Player; }
-	virtual void Draw() override;
 private:
 	Key* m_pCurrentKey;
 	int m_money;
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Writes values of arbitrary bit width MSB first into a caller provided
+// buffer. Writing past the end marks the stream as overflowed instead of
+// touching memory outside the buffer
+class BitWriter
+{
+
+public:
+    BitWriter(uint8_t* buffer, size_t capacity);
+
+    void Write(uint32_t value, uint32_t bits);
+    // 7 bits per byte, high bit set while more bytes follow
+    void WriteVarint(uint32_t value);
+    void WriteByte(uint8_t value);
+
+    // bytes used so far, including a partially filled last byte
+    size_t GetLength() const;
+    bool HasOverflowed() const;
+
+private:
+    uint8_t* m_buffer;
+    size_t m_capacity;
+    size_t m_bitPos;
+    bool m_overflowed;
+};
+
+// Reads back what BitWriter wrote. Reading past the end returns zeros and
+// marks the stream as overflowed, so decoders can check once at the end
+class BitReader
+{
+
+public:
+    BitReader(const uint8_t* data, size_t length);
+
+    uint32_t Read(uint32_t bits);
+    uint32_t ReadVarint();
+    uint8_t ReadByte();
+
+    size_t GetBitsLeft() const;
+    bool HasOverflowed() const;
+
+private:
+    const uint8_t* m_data;
+    size_t m_length;
+    size_t m_bitPos;
+    bool m_overflowed;
+};
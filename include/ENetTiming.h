@@ -0,0 +1,16 @@
+#pragma once
+
+#include <enet/enet.h>
+
+#include <cstdint>
+
+// When a host has to be serviced again even if nothing arrives: ENet only
+// resends and pings from enet_host_service(), and it doesn't wake up for
+// them while it waits on the socket
+namespace ENetTiming
+{
+    // milliseconds until a reliable command of one of host's peers is due
+    // to be resent or a quiet peer to be pinged, at most maxTimeout. 0 if
+    // something is due already
+    uint32_t GetServiceTimeout(const ENetHost* host, uint32_t maxTimeout);
+}
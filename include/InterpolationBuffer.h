@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Protocol.h"
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <vector>
+
+// Jitter buffer for the other players of a room. Snapshots are kept per
+// player with the server time they were taken at, and players are shown as
+// they were a short delay ago, moving between the two samples around that
+// time. The delay follows the jitter measured on arriving snapshots, so it
+// stays small on a steady connection and grows just enough to ride out a
+// bursty one. When the newest sample is already behind the playback time a
+// player keeps going the way it was for a little while, then stops
+class InterpolationBuffer
+{
+
+public:
+    typedef std::chrono::steady_clock Clock;
+    // tells whether a player can't be shown on a tile, checked before
+    // extrapolating onto it
+    typedef std::function<bool(int, int)> IsBlocked;
+
+    InterpolationBuffer();
+
+    // for a new room, its server time starts over
+    void Reset();
+
+    // takes a snapshot that arrived at arrival, late ones are fine
+    void Add(const Protocol::Snapshot& snapshot, Clock::time_point arrival);
+
+    // every other player that is shown at now, sorted by id
+    void Sample(Clock::time_point now, const IsBlocked& isBlocked, std::vector<Protocol::PlayerPosition>& players);
+
+    // in milliseconds
+    uint32_t GetDelay() const;
+    uint32_t GetJitter() const;
+
+private:
+    struct TimedPosition
+    {
+        uint32_t serverTime;
+        // false once the player left the snapshots
+        bool present;
+        int x;
+        int y;
+    };
+
+    // the tile between a at from and b at to that is closest to time
+    static int Lerp(int a, int b, uint32_t from, uint32_t to, double time);
+
+    void Insert(uint32_t peerId, const TimedPosition& sample);
+    bool SamplePlayer(const std::deque<TimedPosition>& samples, double time, const IsBlocked& isBlocked,
+        Protocol::PlayerPosition& player) const;
+
+    Clock::time_point m_epoch;
+    std::map<uint32_t, std::deque<TimedPosition>> m_players;
+
+    bool m_hasTransit;
+    // arrival time minus server time, which is the one way latency plus
+    // the difference between the clocks. The lowest one seen, drifting up
+    // slowly so it follows route changes, stands for the fastest delivery
+    double m_baseTransit;
+    double m_lastTransit;
+    // RFC 3550 interarrival jitter, in milliseconds
+    double m_jitter;
+    // time between the snapshots' server times, smoothed
+    double m_interval;
+    uint32_t m_lastServerTime;
+
+    // reused between snapshots
+    std::vector<uint32_t> m_gone;
+};
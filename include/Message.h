@@ -1,7 +1,9 @@
 #pragma once
 
+#include <enet/enet.h>
+
+#include <cstdint>
 #include <memory>
-#include <string>
 #include <vector>
 
 class Message {
@@ -14,18 +16,26 @@ public:
         DATA
     };
     
-    Message(uint32_t peerId, Type type, const std::string& data);
+    Message(uint32_t peerId, Type type);
+    // a payload inside a received packet, which is destroyed together with
+    // the last message referring to it
+    Message(uint32_t peerId, const std::shared_ptr<ENetPacket>& packet, const uint8_t* data, size_t length);
 
     uint32_t GetPeerID() const;
     Type GetType() const;
 
-    const std::string& GetData() const;
+    // NOTE: points straight into the received packet, valid for as long as
+    // this message (or a copy of it) is alive
+    const uint8_t* GetData() const;
+    size_t GetDataLength() const;
 
 private:  
     
     uint32_t m_peerID;
     Type m_type;
 
-    std::string m_data;
+    std::shared_ptr<ENetPacket> m_packet;
+    const uint8_t* m_data;
+    size_t m_length;
     
 };
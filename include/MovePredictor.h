@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Protocol.h"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+// Client side prediction of the local player. Every step is shown at once
+// and kept until a snapshot acknowledges it; each snapshot then rewinds the
+// player to where the server has it and replays the steps the server
+// hasn't applied yet, so the server keeps the final say without every key
+// press waiting a round trip
+class MovePredictor
+{
+
+public:
+    // tells whether a tile stops a step, the same way the server decides
+    typedef std::function<bool(int, int)> IsBlocked;
+
+    MovePredictor();
+
+    // drops every pending step, for (re)joining a room. Returns the
+    // sequence the JOIN uses up, acknowledgements older than it are from
+    // before the join and get ignored
+    uint32_t Restart();
+
+    // numbers a step the player just took
+    void Push(Protocol::Direction direction);
+
+    // the oldest steps the server hasn't acknowledged, up to maxCount and
+    // oldest first, which is what every INPUT message carries. The server
+    // skips ahead to whatever follows what it applied, so the steps after
+    // those only go out once these were acknowledged
+    size_t GetPending(Protocol::Input* inputs, size_t maxCount) const;
+
+    // false if the snapshot doesn't tell where the player is or is from
+    // before the last restart. Otherwise x and y are set to the server's
+    // position with the pending steps replayed on top
+    bool Reconcile(const Protocol::Snapshot& snapshot, const IsBlocked& isBlocked, int& x, int& y);
+
+    size_t GetPendingCount() const;
+
+private:
+    std::deque<Protocol::Input> m_pending;
+    uint32_t m_nextSequence;
+    uint32_t m_restartSequence;
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// Bounded lock-free queue any number of threads push to and exactly one
+// thread pops from. Every slot carries a sequence number telling whether
+// it is free for the producer at that position or holds a value for the
+// consumer, so producers only contend on claiming a position.
+// Pushing to a full queue fails instead of blocking
+template <typename T>
+class MpscQueue
+{
+
+public:
+    // capacity is rounded up to a power of two
+    explicit MpscQueue(size_t capacity)
+        : m_head(0)
+        , m_tail(0)
+    {
+        size_t size = 1;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        m_cells.reset(new Cell[size]);
+        m_mask = size - 1;
+        for (size_t i = 0; i < size; ++i)
+        {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // any thread
+    bool TryPush(T value)
+    {
+        size_t position = m_tail.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        while (true)
+        {
+            cell = &m_cells[position & m_mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0)
+            {
+                // the slot is free, claim the position
+                if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                // the consumer hasn't freed this slot yet, full
+                return false;
+            }
+            else
+            {
+                // another producer claimed it first
+                position = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = std::move(value);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer only
+    bool TryPop(T& value)
+    {
+        size_t position = m_head.load(std::memory_order_relaxed);
+        Cell& cell = m_cells[position & m_mask];
+        if (cell.sequence.load(std::memory_order_acquire) != position + 1)
+        {
+            // empty, or the producer holding this position hasn't finished
+            return false;
+        }
+
+        value = std::move(cell.value);
+        cell.value = T();
+        // free for the producer one lap ahead
+        cell.sequence.store(position + m_mask + 1, std::memory_order_release);
+        m_head.store(position + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    static const size_t CACHE_LINE_SIZE = 64;
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    size_t m_mask;
+
+    // NOTE: padded so producers claiming positions don't invalidate the
+    // consumer's index
+    char m_padding0[CACHE_LINE_SIZE];
+    std::atomic<size_t> m_head;
+    char m_padding1[CACHE_LINE_SIZE];
+    std::atomic<size_t> m_tail;
+    char m_padding2[CACHE_LINE_SIZE];
+};
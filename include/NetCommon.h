@@ -5,9 +5,11 @@
 #define UNRELIABLE_CHANNEL 1
 #define NUM_CHANNELS 2
 
+// largest packet a SendQueue builds, leaves room for ENet's protocol and
+// command headers so a batch fits the default 1400 byte MTU unfragmented
+#define MAX_BATCH_SIZE 1200
+
 enum class DeliveryType {
     RELIABLE,
     UNRELIABLE
-};
-
-#define MAX_MESSAGE_LEN 100
\ No newline at end of file
+};
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <enet/enet.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// Compression of the UDP datagrams a host sends, as ENet does it: a host
+// compresses everything it sends with its compressor and needs the same
+// one to decompress what it receives, so both ends of a connection have to
+// use the same type. ENet sends a datagram as it is whenever compressing
+// wouldn't make it smaller.
+// ZERO_PACK is made for the small datagrams the game sends: ENet's command
+// headers, frame lengths and varints are full of zero bytes, while the bit
+// packed coordinates after them hardly compress at all. Each group of 8
+// bytes becomes a byte telling which of them aren't zero, followed by
+// those, which takes a few nanoseconds and never needs to learn anything
+// from the datagram first like the range coder does
+namespace PacketCompression
+{
+    enum class Type
+    {
+        NONE,
+        // ENet's own adaptive range coder
+        RANGE_CODER,
+        ZERO_PACK
+    };
+
+    // "none", "range" or "zeropack", false for anything else
+    bool Parse(const char* name, Type& type);
+    const char* GetName(Type type);
+
+    // from now on host compresses what it sends and decompresses what it
+    // receives with type. Returns false if ENet couldn't set it up
+    bool Enable(ENetHost* host, Type type);
+
+    // ENetCompressor callbacks of ZERO_PACK, return the length written or
+    // 0 if it doesn't fit outLimit or the data is malformed
+    size_t ENET_CALLBACK ZeroPack(void* context, const ENetBuffer* inBuffers, size_t inBufferCount, size_t inLimit,
+        uint8_t* outData, size_t outLimit);
+    size_t ENET_CALLBACK ZeroUnpack(void* context, const uint8_t* inData, size_t inLimit, uint8_t* outData, size_t outLimit);
+}
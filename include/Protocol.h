@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Binary wire format shared by the game client and the server.
+//
+// Every message starts with a two byte header (protocol version, message
+// type) followed by a bit packed body. Coordinates are written with just
+// enough bits to cover the level they belong to, ids are varints.
+namespace Protocol
+{
+    const uint8_t VERSION = 6;
+
+    // largest message either side builds on the stack before sending
+    const size_t MAX_MESSAGE_SIZE = 1024;
+
+    // snapshot sequences start at 1, a delta against NO_BASELINE is a full
+    // snapshot
+    const uint32_t NO_BASELINE = 0;
+
+    // input sequences start at 1 as well, and keep counting across rooms
+    // for as long as the client stays connected
+    const uint32_t NO_INPUT = 0;
+
+    // inputs go out unreliably, every INPUT message repeats the newest
+    // steps the server hasn't acknowledged yet, up to this many
+    const size_t MAX_INPUTS_PER_MESSAGE = 32;
+
+    enum class MessageType : uint8_t
+    {
+        // client -> server: the latest steps of the sender's own player,
+        // which the server applies unless they run into a wall. Steps it
+        // already applied are skipped
+        INPUT,
+        // server -> client: every other player's position, either in full
+        // or as the difference to a snapshot the client acknowledged
+        SNAPSHOT,
+        // client -> server: newest snapshot the client has applied
+        SNAPSHOT_ACK,
+        // client -> server: move the sender to the spawn of a room, leaving
+        // the one it was in. Joining the room the sender is already in
+        // respawns it there
+        JOIN,
+        COUNT
+    };
+
+    // bits needed per axis to address every cell of a level
+    struct CoordinateBits
+    {
+        uint8_t x;
+        uint8_t y;
+
+        static CoordinateBits ForLevel(int width, int height);
+    };
+
+    enum class Direction : uint8_t
+    {
+        LEFT,
+        RIGHT,
+        UP,
+        DOWN
+    };
+
+    // moves x and y one tile towards direction
+    void Step(Direction direction, int& x, int& y);
+
+    struct Input
+    {
+        uint32_t sequence;
+        Direction direction;
+    };
+
+    struct PlayerPosition
+    {
+        uint32_t peerId;
+        int x;
+        int y;
+    };
+
+    struct Snapshot
+    {
+        // sequences restart in every room, a client that switched rooms
+        // drops what the old one still had in flight
+        uint32_t roomId;
+        uint32_t sequence;
+        // milliseconds since the room opened, of the tick the snapshot was
+        // built on. Lets clients play players back at the pace they moved
+        uint32_t serverTime = 0;
+        // sorted by peerId
+        std::vector<PlayerPosition> players;
+
+        // the recipient's own position as the server has it, after applying
+        // its inputs up to inputSequence. Not set before the recipient
+        // joined the room
+        bool hasSelf = false;
+        int selfX = 0;
+        int selfY = 0;
+        uint32_t inputSequence = NO_INPUT;
+    };
+
+    // upper bounds of the encoded sizes, to reserve space before encoding
+    size_t GetMaxInputSize();
+    size_t GetMaxSnapshotSize(size_t playerCount, size_t baselinePlayerCount);
+    size_t GetMaxSnapshotAckSize();
+    size_t GetMaxJoinSize();
+
+    // returns the encoded length, 0 if the message doesn't fit or a
+    // coordinate is outside the level.
+    // With a baseline only players that moved, appeared or disappeared
+    // since it are written
+    // inputs are oldest first and their sequences must follow each other
+    size_t EncodeInputs(const Input* inputs, size_t count, uint8_t* buffer, size_t capacity);
+    size_t EncodeSnapshot(const Snapshot& snapshot, const Snapshot* baseline, CoordinateBits bits, uint8_t* buffer, size_t capacity);
+    size_t EncodeSnapshotAck(uint32_t sequence, uint8_t* buffer, size_t capacity);
+    // inputSequence is a sequence number the join uses up, snapshots
+    // acknowledging it or anything after it are from after the join
+    size_t EncodeJoin(uint32_t roomId, uint32_t inputSequence, uint8_t* buffer, size_t capacity);
+
+    // false if the data is too short or was written by another version
+    bool ReadType(const uint8_t* data, size_t length, MessageType& type);
+
+    // inputs needs room for MAX_INPUTS_PER_MESSAGE
+    bool DecodeInputs(const uint8_t* data, size_t length, Input* inputs, size_t& count);
+    // tells which room a snapshot is from and which snapshot a delta needs
+    // before decoding it
+    bool ReadSnapshotHeader(const uint8_t* data, size_t length, uint32_t& roomId, uint32_t& sequence, uint32_t& baselineSequence);
+    // baseline must be the snapshot named by ReadSnapshotHeader, nullptr
+    // for full snapshots
+    bool DecodeSnapshot(const uint8_t* data, size_t length, const Snapshot* baseline, Snapshot& snapshot);
+    bool DecodeSnapshotAck(const uint8_t* data, size_t length, uint32_t& sequence);
+    bool DecodeJoin(const uint8_t* data, size_t length, uint32_t& roomId, uint32_t& inputSequence);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "NetCommon.h"
+#include "Message.h"
+
+#include <enet/enet.h>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Collects the messages sent to one destination during a tick and packs
+// them into as few ENet packets as possible, so a tick costs one datagram
+// per destination instead of one per message.
+// Each packet is a sequence of [varint length][payload] frames and never
+// grows past MAX_BATCH_SIZE unless a single message is larger than that.
+// Frames are written straight into the ENetPacket that will be sent, so a
+// message encoded through Reserve()/Commit() is never copied.
+class SendQueue
+{
+
+public:
+    SendQueue();
+    ~SendQueue();
+
+    SendQueue(const SendQueue&) = delete;
+    SendQueue& operator=(const SendQueue&) = delete;
+
+    void Queue(DeliveryType type, const uint8_t* data, size_t length);
+
+    // returns room for a message of up to maxLength bytes inside the packet
+    // being built. Encode into it, then Commit() the length actually used
+    // (0 drops the message, as does queueing an empty one). Nothing else
+    // may be queued in between
+    uint8_t* Reserve(DeliveryType type, size_t maxLength);
+    void Commit(size_t length);
+
+    bool IsEmpty() const;
+
+    // hands every packet built since the last flush to send along with the
+    // channel it belongs on, the callee takes ownership of the packet
+    void Flush(const std::function<void(uint8_t, ENetPacket*)>& send);
+
+    // splits a received batch into one message per frame, all of them
+    // sharing the packet. Returns false if the packet is malformed
+    static bool Unpack(uint32_t peerId, ENetPacket* packet, std::vector<Message>& messages);
+
+private:
+    struct Channel
+    {
+        // packet currently being filled and how much of it is used
+        ENetPacket* current;
+        size_t length;
+        std::vector<ENetPacket*> packets;
+    };
+
+    void FinishPacket(uint8_t channelId);
+
+    Channel m_channels[NUM_CHANNELS];
+
+    // frame handed out by Reserve() and waiting for Commit()
+    uint8_t m_reservedChannel;
+    size_t m_reservedHeaderSize;
+};
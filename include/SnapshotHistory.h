@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Protocol.h"
+
+#include <cstdint>
+
+// Ring of the most recent snapshots, looked up by sequence. The server keeps
+// what it sent to each client, a client keeps what it applied, so both ends
+// can find the baseline a delta refers to
+class SnapshotHistory
+{
+
+public:
+    static const uint32_t SIZE = 32;
+
+    SnapshotHistory();
+
+    void Store(const Protocol::Snapshot& snapshot);
+    // nullptr once the snapshot has been overwritten by newer ones
+    const Protocol::Snapshot* Find(uint32_t sequence) const;
+    void Clear();
+
+private:
+    Protocol::Snapshot m_snapshots[SIZE];
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Protocol.h"
+#include "SnapshotHistory.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Client side of the snapshot stream of one room: drops snapshots that are
+// stale, from another room or against a baseline that is no longer known,
+// and rebuilds the rest from their baselines. The caller acknowledges every
+// snapshot Receive() accepted
+class SnapshotReceiver
+{
+
+public:
+    SnapshotReceiver();
+
+    // forgets everything, snapshots are taken from roomId from now on
+    void Reset(uint32_t roomId);
+
+    // false if the snapshot was dropped
+    bool Receive(const uint8_t* data, size_t length);
+
+    // the last snapshot accepted
+    const Protocol::Snapshot& GetSnapshot() const;
+    uint32_t GetLastSequence() const;
+    uint32_t GetRoomID() const;
+
+private:
+    Protocol::Snapshot m_snapshot;
+    Protocol::Snapshot m_decoded;
+    // snapshots accepted recently, the server sends deltas against them
+    SnapshotHistory m_history;
+    uint32_t m_lastSequence;
+    uint32_t m_roomId;
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Bounded lock-free queue between exactly one producer thread and exactly
+// one consumer thread. Pushing to a full queue fails instead of blocking,
+// the producer decides whether to retry or drop
+template <typename T>
+class SpscQueue
+{
+
+public:
+    // capacity is rounded up to a power of two
+    explicit SpscQueue(size_t capacity)
+        : m_head(0)
+        , m_tail(0)
+    {
+        size_t size = 1;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        m_slots.resize(size);
+        m_mask = size - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // producer only
+    bool TryPush(T value)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) > m_mask)
+        {
+            return false;
+        }
+        m_slots[tail & m_mask] = std::move(value);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer only
+    bool TryPop(T& value)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        // moved out so the slot doesn't keep resources alive until reused
+        value = std::move(m_slots[head & m_mask]);
+        m_slots[head & m_mask] = T();
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // only a hint while the other side is running
+    bool IsEmpty() const
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+private:
+    // NOTE: padded so the producer and consumer indices don't share a
+    // cache line and bounce it between cores
+    static const size_t CACHE_LINE_SIZE = 64;
+
+    std::vector<T> m_slots;
+    size_t m_mask;
+
+    char m_padding0[CACHE_LINE_SIZE];
+    std::atomic<size_t> m_head;
+    char m_padding1[CACHE_LINE_SIZE];
+    std::atomic<size_t> m_tail;
+    char m_padding2[CACHE_LINE_SIZE];
+};
@@ -1,15 +1,82 @@
 #include "ENetServer.h"
 
+#include "ENetTiming.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <ctime>
+#include <functional>
 
-const uint32_t MAX_CONNECTIONS = 64;
+// how soon an I/O thread tries again to hand over events that didn't fit
+// in its incoming queue, in milliseconds
+const uint32_t BACKLOG_RETRY_MS = 1;
+// how many times a full outgoing queue is retried, a millisecond apart,
+// before the packet is dropped
+const uint32_t OUTGOING_PUSH_RETRIES = 5;
+// queue capacities in events and packets per shard, the I/O thread keeps
+// servicing its host even when the game falls behind draining them
+const size_t INCOMING_QUEUE_SIZE = 4096;
+const size_t OUTGOING_QUEUE_SIZE = 8192;
+// how often an I/O thread copies its host's counters and peer estimates
+// for GetStats()
+const auto STATS_SAMPLE_INTERVAL = std::chrono::milliseconds(250);
+// ENet's throttle compares round trip times over this interval, its default
+// of 5 seconds is slow to notice a link filling up
+const uint32_t PEER_THROTTLE_INTERVAL_MS = 1000;
+// how fast the throttle backs off, per step of the client's send interval,
+// so a client already sent less drops unreliable packets sooner still
+const uint32_t PEER_THROTTLE_DECELERATION = ENET_PEER_PACKET_THROTTLE_DECELERATION;
 
-char ENetServer::MESSAGE_BUFFER[] = {};
+// a nonblocking UDP socket on a free loopback port, ENET_SOCKET_NULL if
+// there is none
+static ENetSocket OpenWakeSocket(ENetAddress& address)
+{
+    ENetSocket socket = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+    if (socket == ENET_SOCKET_NULL)
+    {
+        return socket;
+    }
+
+    enet_address_set_host_ip(&address, "127.0.0.1");
+    address.port = 0;
+    if (enet_socket_bind(socket, &address) < 0 || enet_socket_get_address(socket, &address) < 0
+        || enet_socket_set_option(socket, ENET_SOCKOPT_NONBLOCK, 1) < 0)
+    {
+        enet_socket_destroy(socket);
+        return ENET_SOCKET_NULL;
+    }
+    // bound to any interface's address on some systems, the byte goes
+    // to loopback either way
+    enet_address_set_host_ip(&address, "127.0.0.1");
+    return socket;
+}
+
+ENetServer::Shard::Shard(uint32_t index, ENetHost* host, ENetSocket wakeSocket, const ENetAddress& wakeAddress,
+    uint32_t peerCount)
+    : index(index)
+    , host(host)
+    , ioRunning(false)
+    , incoming(INCOMING_QUEUE_SIZE)
+    , outgoing(OUTGOING_QUEUE_SIZE)
+    , droppedPackets(0)
+    , wakeSocket(wakeSocket)
+    , wakeAddress(wakeAddress)
+    , wakePending(false)
+    , lastStatsSample(std::chrono::steady_clock::now())
+    , nextStatsSample(lastStatsSample)
+    , sendIntervals(new std::atomic<uint32_t>[peerCount])
+{
+    for (uint32_t i = 0; i < peerCount; ++i)
+    {
+        sendIntervals[i].store(1, std::memory_order_relaxed);
+    }
+}
 
 ENetServer::ENetServer()
-    : m_host(nullptr)
+    : m_peersPerShard(0)
+    , m_compression(PacketCompression::Type::NONE)
+    , m_pollInterrupted(false)
 {
     // initialize enet
     // TODO: prevent this from being called multiple times
@@ -27,270 +94,712 @@ ENetServer::~ENetServer()
     enet_deinitialize();
 }
 
-bool ENetServer::Start(uint32_t port)
-{
-    // create address
-    ENetAddress address;
-    enet_address_set_host(&address, "localhost");
-    address.port = port;
-    // create host
-    m_host = enet_host_create(
-        &address, // the address to bind the server host to
-        MAX_CONNECTIONS, // allow up to N clients and/or outgoing connections
-        NUM_CHANNELS, // allow up to N channels to be used
-        0, // assume any amount of incoming bandwidth
-        0); // assume any amount of outgoing bandwidth
-    // check if creation was successful
-    // NOTE: this only fails if malloc fails inside `enet_host_create`
-    if (m_host == nullptr) 
-    {        
+bool ENetServer::Start(uint32_t port, uint32_t maxPeers, uint32_t shardCount, const std::string& bindAddress,
+    uint32_t outgoingBandwidth)
+{
+    if (IsRunning() || shardCount == 0)
+    {
         return 1;
     }
+
+    m_peersPerShard = (maxPeers + shardCount - 1) / shardCount;
+    if (m_peersPerShard == 0 || m_peersPerShard > MAX_PEERS_PER_SHARD)
+    {
+        return 1;
+    }
+
+    for (uint32_t i = 0; i < shardCount; ++i)
+    {
+        // create address, shards listen on adjacent ports
+        ENetAddress address;
+        enet_address_set_host(&address, bindAddress.c_str());
+        address.port = static_cast<enet_uint16>(port + i);
+        // create host
+        ENetHost* host = enet_host_create(
+            &address, // the address to bind the server host to
+            m_peersPerShard, // allow up to N clients and/or outgoing connections
+            NUM_CHANNELS, // allow up to N channels to be used
+            0, // assume any amount of incoming bandwidth
+            outgoingBandwidth / shardCount); // ENet shares this out between the clients, 0 for any amount
+        // check if creation was successful
+        // NOTE: fails if malloc fails inside `enet_host_create` or the
+        // port is taken
+        if (host != nullptr && !PacketCompression::Enable(host, m_compression))
+        {
+            enet_host_destroy(host);
+            host = nullptr;
+        }
+        ENetAddress wakeAddress;
+        ENetSocket wakeSocket = host != nullptr ? OpenWakeSocket(wakeAddress) : ENET_SOCKET_NULL;
+        if (host != nullptr && wakeSocket == ENET_SOCKET_NULL)
+        {
+            enet_host_destroy(host);
+            host = nullptr;
+        }
+        if (host == nullptr) 
+        {
+            for (auto& shard : m_shards)
+            {
+                StopIO(*shard);
+            }
+            DestroyShards();
+            return 1;
+        }
+
+        m_shards.emplace_back(new Shard(i, host, wakeSocket, wakeAddress, m_peersPerShard));
+
+        // from here on only the I/O thread touches the host
+        Shard& shard = *m_shards.back();
+        shard.ioRunning.store(true, std::memory_order_release);
+        shard.ioThread = std::thread(&ENetServer::RunIO, this, std::ref(shard));
+    }
     return 0;
 }
 
-bool ENetServer::Stop()
+bool ENetServer::Stop(std::vector<uint32_t>* timedOut)
 {
     if (!IsRunning()) 
     {
         // no clients to disconnect from
         return 0;
     }
-    // attempt to gracefully disconnect all clients
-    
-    for (auto iter : m_clients) 
+    // send whatever is still queued before saying goodbye, then take the
+    // hosts back from the I/O threads
+    Flush();
+    for (auto& shard : m_shards)
+    {
+        StopIO(*shard);
+    }
+
+    bool success = DisconnectAll(timedOut);
+
+    // clear clients
+    m_sendQueues.clear();
+    DestroyShards();
+    return !success;
+}
+
+bool ENetServer::IsRunning() const
+{
+    return !m_shards.empty();
+}
+
+bool ENetServer::SetCompression(PacketCompression::Type compression)
+{
+    if (IsRunning())
+    {
+        return false;
+    }
+    m_compression = compression;
+    return true;
+}
+
+uint32_t ENetServer::NumClients() const
+{
+    // as of the last Poll(), the hosts themselves belong to the I/O threads
+    return static_cast<uint32_t>(m_sendQueues.size());
+}
+
+uint32_t ENetServer::NumShards() const
+{
+    return static_cast<uint32_t>(m_shards.size());
+}
+
+uint32_t ENetServer::GetClientID(const Shard& shard, uint32_t peerId) const
+{
+    return shard.index * m_peersPerShard + peerId;
+}
+
+ENetServer::Shard* ENetServer::GetShard(uint32_t id) const
+{
+    uint32_t index = m_peersPerShard > 0 ? id / m_peersPerShard : 0;
+    if (index >= m_shards.size())
+    {
+        return nullptr;
+    }
+    return m_shards[index].get();
+}
+
+void ENetServer::Send(uint32_t id, DeliveryType type, const std::string& messageStr)
+{
+    Send(id, type, reinterpret_cast<const uint8_t*>(messageStr.data()), messageStr.size());
+}
+
+void ENetServer::Send(uint32_t id, DeliveryType type, const uint8_t* data, size_t length)
+{
+    auto iter = m_sendQueues.find(id);
+    if (iter == m_sendQueues.end()) 
     {
-        auto client = iter.second;
+        // no client to send to
         
-        enet_peer_disconnect(client, 0);
+        return;
     }
-    // wait for the disconnections to be acknowledged
-    auto timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
-        std::chrono::system_clock::now().time_since_epoch())
-        .count();;
-    bool success = false;
-    ENetEvent event;
+
+    // queued until the next Flush(), batched with everything else sent to
+    // this client during the tick
+    iter->second.Queue(type, data, length);
+}
+
+void ENetServer::Send(uint32_t id, uint8_t channel, ENetPacket* packet)
+{
+    Shard* shard = GetShard(id);
+    if (shard == nullptr)
+    {
+        enet_packet_destroy(packet);
+        return;
+    }
+
+    // goes out with the I/O thread's next pass, but isn't batched any further
+    OutgoingPacket outgoing;
+    outgoing.broadcast = false;
+    outgoing.peerId = id - shard->index * m_peersPerShard;
+    outgoing.channel = channel;
+    outgoing.packet = packet;
+    PushOutgoing(*shard, outgoing);
+}
+
+uint8_t* ENetServer::BeginSend(uint32_t id, DeliveryType type, size_t maxLength)
+{
+    auto iter = m_sendQueues.find(id);
+    if (iter == m_sendQueues.end())
+    {
+        // no client to send to
+        return nullptr;
+    }
+    return iter->second.Reserve(type, maxLength);
+}
+
+void ENetServer::CommitSend(uint32_t id, size_t length)
+{
+    auto iter = m_sendQueues.find(id);
+    if (iter != m_sendQueues.end())
+    {
+        iter->second.Commit(length);
+    }
+}
+
+void ENetServer::Broadcast(DeliveryType type, const std::string& messageStr)
+{
+    Broadcast(type, reinterpret_cast<const uint8_t*>(messageStr.data()), messageStr.size());
+}
+
+void ENetServer::Broadcast(DeliveryType type, const uint8_t* data, size_t length)
+{
+    if (NumClients() == 0) 
+    {
+        // no clients to broadcast to
+        return;
+    }
+
+    m_broadcastQueue.Queue(type, data, length);
+}
+
+void ENetServer::Flush()
+{
+    m_broadcastQueue.Flush([this](uint8_t channel, ENetPacket* packet) {
+        // hosts can't share a packet across threads, every shard after the
+        // first one gets its own copy
+        for (size_t i = 0; i < m_shards.size(); ++i)
+        {
+            OutgoingPacket outgoing;
+            outgoing.broadcast = true;
+            outgoing.peerId = 0;
+            outgoing.channel = channel;
+            outgoing.packet = i + 1 == m_shards.size() ? packet
+                : enet_packet_create(packet->data, packet->dataLength, packet->flags);
+            PushOutgoing(*m_shards[i], outgoing);
+        }
+    });
+
+    for (auto& iter : m_sendQueues)
+    {
+        if (iter.second.IsEmpty())
+        {
+            continue;
+        }
+
+        uint32_t id = iter.first;
+        iter.second.Flush([this, id](uint8_t channel, ENetPacket* packet) {
+            Send(id, channel, packet);
+        });
+    }
+}
+
+std::vector<Message> ENetServer::Poll(uint32_t timeoutMs)
+{
+    std::vector<Message> msgs;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    IncomingEvent event;
     while (true) 
     {
-        int32_t res = enet_host_service(m_host, &event, 0);
-        if (res > 0) 
+        for (auto& shard : m_shards)
         {
-            // event occured
-            if (event.type == ENET_EVENT_TYPE_RECEIVE) 
-            {
-                // throw away any received packets during disconnect
-                
-                enet_packet_destroy(event.packet);
-            } 
-            else if (event.type == ENET_EVENT_TYPE_DISCONNECT) 
-            {
-                // disconnect successful
-               
-                // remove from remaining
-                m_clients.erase(event.peer->incomingPeerID);
-            } 
-            else if (event.type == ENET_EVENT_TYPE_CONNECT) 
+            while (shard->incoming.TryPop(event))
             {
-                // client connected
-                
-                   
-                // add and remove client
-                enet_peer_disconnect(event.peer, 0);
-                // add to remaining
-                m_clients[event.peer->incomingPeerID] = event.peer;
+                HandleIncoming(*shard, event, msgs);
             }
-        } 
-        else if (res < 0) 
+        }
+
+        if (!msgs.empty())
         {
-            // error occured
-            
             break;
-        } 
-        else 
+        }
+
+        // sleep until an I/O thread rings, someone interrupts or the
+        // deadline passes
+        std::unique_lock<std::mutex> lock(m_doorbellMutex);
+        if (!m_doorbell.wait_until(lock, deadline, [this]() { return HasIncoming() || m_pollInterrupted; }))
         {
-            // no event, check if finished
-            if (m_clients.empty()) 
-            {
-                // all clients successfully disconnected
-                
-                success = true;
-                break;
-            }
+            break;
         }
-        // check timeout
-        auto timestampNow = std::chrono::duration_cast<std::chrono::microseconds>(
-            std::chrono::system_clock::now().time_since_epoch())
-            .count();
-        if (timestampNow - timestamp > TIMEOUT_MS * 1000) 
+        if (m_pollInterrupted)
         {
-            
+            // whatever arrived meanwhile is picked up by the next Poll()
+            m_pollInterrupted = false;
             break;
         }
     }
-    // force disconnect the remaining clients
-    for (auto iter : m_clients) 
+    return msgs;
+}
+
+void ENetServer::InterruptPoll()
+{
     {
-        auto id = iter.first;
-        auto client = iter.second;
-        
-        enet_peer_reset(client);
+        std::lock_guard<std::mutex> lock(m_doorbellMutex);
+        m_pollInterrupted = true;
     }
-    // clear clients
-    m_clients = std::map<uint32_t, ENetPeer*>();
-    // destroy the host
-    enet_host_destroy(m_host);
-    m_host = nullptr;
-    return !success;
+    m_doorbell.notify_one();
 }
 
-bool ENetServer::IsRunning() const
+void ENetServer::GetStats(Stats& stats) const
 {
-    return m_host != nullptr;
+    stats = Stats();
+    for (const auto& shard : m_shards)
+    {
+        std::lock_guard<std::mutex> lock(shard->statsMutex);
+        stats.packetsSent += shard->stats.packetsSent;
+        stats.bytesSent += shard->stats.bytesSent;
+        stats.packetsReceived += shard->stats.packetsReceived;
+        stats.bytesReceived += shard->stats.bytesReceived;
+        stats.packetsDropped += shard->droppedPackets.load(std::memory_order_relaxed);
+        stats.peers.insert(stats.peers.end(), shard->stats.peers.begin(), shard->stats.peers.end());
+    }
 }
 
-uint32_t ENetServer::NumClients() const
+uint32_t ENetServer::GetSendInterval(uint32_t id) const
 {
-    return static_cast<uint32_t>(m_host->connectedPeers);
+    Shard* shard = GetShard(id);
+    if (shard == nullptr)
+    {
+        return 1;
+    }
+    return shard->sendIntervals[id - shard->index * m_peersPerShard].load(std::memory_order_relaxed);
 }
 
-ENetPeer* ENetServer::GetClient(uint32_t id) const
+void ENetServer::PushOutgoing(Shard& shard, const OutgoingPacket& outgoing)
 {
-    auto iter = m_clients.find(id);
-    if (iter == m_clients.end()) 
+    // NOTE: the queue is only full if the I/O thread is far behind. It gets
+    // a few milliseconds to catch up, then the packet is dropped rather
+    // than holding up the room sending it
+    bool pushed = shard.outgoing.TryPush(outgoing);
+    for (uint32_t attempt = 0; !pushed && attempt < OUTGOING_PUSH_RETRIES; ++attempt)
     {
-        // no client to send to
-        
-        return nullptr;
+        Wake(shard);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        pushed = shard.outgoing.TryPush(outgoing);
     }
-    return iter->second;
-}
 
+    if (!pushed)
+    {
+        enet_packet_destroy(outgoing.packet);
+        shard.droppedPackets.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    Wake(shard);
+}
 
-void ENetServer::Send(uint32_t id, DeliveryType type, const std::string& messageStr) const
+void ENetServer::Wake(Shard& shard)
 {
-    auto client = GetClient(id);
-    if (!client) 
+    // one byte wakes the I/O thread for everything pushed until it looks
+    // at the queue again
+    if (shard.wakePending.exchange(true, std::memory_order_acq_rel))
     {
-        // no client to send to
-        
         return;
     }
-    uint32_t channel = 0;
-    uint32_t flags = 0;
-    if (type == DeliveryType::RELIABLE) 
+
+    uint8_t byte = 0;
+    ENetBuffer buffer;
+    buffer.data = &byte;
+    buffer.dataLength = sizeof(byte);
+    enet_socket_send(shard.wakeSocket, &shard.wakeAddress, &buffer, 1);
+}
+
+void ENetServer::HandleIncoming(const Shard& shard, const IncomingEvent& event, std::vector<Message>& msgs)
+{
+    uint32_t id = GetClientID(shard, event.peerId);
+    if (event.type == ENET_EVENT_TYPE_RECEIVE) 
     {
-        channel = RELIABLE_CHANNEL;
-        flags = ENET_PACKET_FLAG_RELIABLE;
+        // received a batch, the messages in it take ownership of the
+        // packet so payloads are handed out without a copy
+        SendQueue::Unpack(id, event.packet, msgs);
     } 
-    else 
+    else if (event.type == ENET_EVENT_TYPE_CONNECT) 
     {
-        channel = UNRELIABLE_CHANNEL;
-        flags = ENET_PACKET_FLAG_UNSEQUENCED;
+        // client connected
+        msgs.emplace_back(id, Message::Type::CONNECT);
+        m_sendQueues[id];
+    } 
+    else if (event.type == ENET_EVENT_TYPE_DISCONNECT) 
+    {
+        // client disconnected
+        msgs.emplace_back(id, Message::Type::DISCONNECT);
+        m_sendQueues.erase(id);
     }
+}
 
-    // get bytes
-
-    ENetPacket* p = enet_packet_create(
-        messageStr.c_str(),
-        strlen(messageStr.c_str()) + 1,
-        flags);
-
-    // send the packet to the peer
-    enet_peer_send(client, channel, p);
-    // flush / send the packet queue
-    enet_host_flush(m_host);
+bool ENetServer::HasIncoming() const
+{
+    for (const auto& shard : m_shards)
+    {
+        if (!shard->incoming.IsEmpty())
+        {
+            return true;
+        }
+    }
+    return false;
 }
 
-void ENetServer::Broadcast(DeliveryType type, const std::string& messageStr) const
+void ENetServer::StopIO(Shard& shard)
 {
-    if (NumClients() == 0) 
+    if (!shard.ioThread.joinable())
     {
-        // no clients to broadcast to
         return;
     }
 
-    uint32_t channel = 0;
-    uint32_t flags = 0;
-    if (type == DeliveryType::RELIABLE) 
+    shard.ioRunning.store(false, std::memory_order_release);
+    Wake(shard);
+    shard.ioThread.join();
+
+    // nobody is going to read these anymore
+    IncomingEvent event;
+    while (shard.incoming.TryPop(event))
     {
-        channel = RELIABLE_CHANNEL;
-        flags = ENET_PACKET_FLAG_RELIABLE;
-    } 
-    else 
+        shard.incomingBacklog.push_back(event);
+    }
+    for (const auto& backlogged : shard.incomingBacklog)
     {
-        channel = UNRELIABLE_CHANNEL;
-        flags = ENET_PACKET_FLAG_UNSEQUENCED;
+        if (backlogged.packet != nullptr)
+        {
+            enet_packet_destroy(backlogged.packet);
+        }
     }
+    shard.incomingBacklog.clear();
+}
 
-    // get bytes
+bool ENetServer::DisconnectAll(std::vector<uint32_t>* timedOut)
+{
+    // attempt to gracefully disconnect all clients, once what is still
+    // queued for them went out
+    for (auto& shard : m_shards)
+    {
+        for (auto iter : shard->clients) 
+        {
+            enet_peer_disconnect_later(iter.second, 0);
+        }
+    }
+
+    // wait for the disconnections to be acknowledged
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(TIMEOUT_MS);
+    while (true) 
+    {
+        bool success = true;
+        for (auto& shard : m_shards)
+        {
+            // sends and resends what is due, then handles what arrived
+            ENetEvent event;
+            while (enet_host_service(shard->host, &event, 0) > 0)
+            {
+                if (event.type == ENET_EVENT_TYPE_RECEIVE) 
+                {
+                    // throw away any received packets during disconnect
+                    enet_packet_destroy(event.packet);
+                } 
+                else if (event.type == ENET_EVENT_TYPE_DISCONNECT) 
+                {
+                    // disconnect successful, remove from remaining
+                    shard->clients.erase(event.peer->incomingPeerID);
+                } 
+                else if (event.type == ENET_EVENT_TYPE_CONNECT) 
+                {
+                    // draining, nobody new gets in
+                    enet_peer_disconnect_now(event.peer, 0);
+                }
+            }
+            success = success && shard->clients.empty();
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (success || now >= deadline)
+        {
+            break;
+        }
 
-    ENetPacket* p = enet_packet_create(
-        messageStr.c_str(),
-        strlen(messageStr.c_str()) + 1,
-        flags);
+        // sleep until a shard's socket has something or one of its hosts
+        // has to resend, rather than spinning. Rounded up, waking a little
+        // early would only spin until the deadline
+        auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(deadline - now).count();
+        uint32_t timeout = static_cast<uint32_t>(std::min<long long>((remaining + 999) / 1000, TIMEOUT_MS));
+        ENetSocketSet readSet;
+        ENET_SOCKETSET_EMPTY(readSet);
+        ENetSocket maxSocket = 0;
+        for (auto& shard : m_shards)
+        {
+            ENET_SOCKETSET_ADD(readSet, shard->host->socket);
+            maxSocket = std::max(maxSocket, shard->host->socket);
+            timeout = ENetTiming::GetServiceTimeout(shard->host, timeout);
+        }
+        enet_socketset_select(maxSocket, &readSet, nullptr, timeout);
+    }
 
-    // send the packet to the peer
-    enet_host_broadcast(m_host, channel, p);
-    // flush / send the packet queue
-    enet_host_flush(m_host);
+    bool success = true;
+    for (auto& shard : m_shards)
+    {
+        for (auto iter : shard->clients)
+        {
+            success = false;
+            if (timedOut != nullptr)
+            {
+                timedOut->push_back(GetClientID(*shard, iter.first));
+            }
+        }
+    }
+    return success;
 }
 
-std::vector<Message> ENetServer::Poll()
+void ENetServer::DestroyShards()
 {
-    std::vector<Message> msgs;
-    ENetEvent event;
-    while (true) 
+    for (auto& shard : m_shards)
     {
-        // poll with a zero timeout
-        int32_t res = enet_host_service(m_host, &event, 0);
-        if (res > 0) 
+        // force disconnect the remaining clients
+        for (auto iter : shard->clients) 
         {
-            // event occured
-            if (event.type == ENET_EVENT_TYPE_RECEIVE) 
-            {
-                // received a packet
+            enet_peer_reset(iter.second);
+        }
+        shard->clients.clear();
+        // destroy the host
+        enet_host_destroy(shard->host);
+        enet_socket_destroy(shard->wakeSocket);
+    }
+    m_shards.clear();
+}
 
-                memcpy(MESSAGE_BUFFER, event.packet->data, event.packet->dataLength);
-                
-                Message msg = Message(event.peer->incomingPeerID, Message::Type::DATA, MESSAGE_BUFFER);
+void ENetServer::RunIO(Shard& shard)
+{
+    while (shard.ioRunning.load(std::memory_order_acquire))
+    {
+        // the bytes only woke us up, what was pushed is in the queue. A push
+        // after the flag is cleared sends another byte
+        uint8_t bytes[64];
+        ENetBuffer buffer;
+        buffer.data = bytes;
+        buffer.dataLength = sizeof(bytes);
+        while (enet_socket_receive(shard.wakeSocket, nullptr, &buffer, 1) > 0)
+        {
+        }
+        shard.wakePending.exchange(false, std::memory_order_acq_rel);
 
-                msgs.push_back(msg);                
+        SendOutgoing(shard);
 
-                // destroy packet payload
-                enet_packet_destroy(event.packet);
+        // events that didn't fit last time go first, to keep them in order
+        while (!shard.incomingBacklog.empty() && shard.incoming.TryPush(shard.incomingBacklog.front()))
+        {
+            shard.incomingBacklog.pop_front();
+        }
 
-            } 
-            else if (event.type == ENET_EVENT_TYPE_CONNECT) 
+        // sends what was just queued and resends what is due, then handles
+        // what arrived
+        ENetEvent event;
+        bool received = false;
+        int32_t res = enet_host_service(shard.host, &event, 0);
+        while (res > 0)
+        {
+            IncomingEvent incoming;
+            incoming.type = event.type;
+            incoming.peerId = event.peer->incomingPeerID;
+            incoming.packet = nullptr;
+
+            if (event.type == ENET_EVENT_TYPE_RECEIVE)
             {
-                // client connected
-                
-                // add msg
-                Message msg = Message( event.peer->incomingPeerID, Message::Type::CONNECT, "");
-                msgs.push_back(msg);
-                m_clients[event.peer->incomingPeerID] = event.peer;
-
-            } 
-            else if (event.type == ENET_EVENT_TYPE_DISCONNECT) 
+                incoming.packet = event.packet;
+            }
+            else if (event.type == ENET_EVENT_TYPE_CONNECT)
             {
-                // client disconnected
-                
-                // add msg
-                Message msg = Message(event.peer->incomingPeerID, Message::Type::DISCONNECT, "");
-                msgs.push_back(msg);
-                m_clients.erase(event.peer->incomingPeerID);
+                AddPeer(shard, incoming.peerId, event.peer);
             }
-        } 
-        else if (res < 0) 
+            else if (event.type == ENET_EVENT_TYPE_DISCONNECT)
+            {
+                RemovePeer(shard, incoming.peerId);
+            }
+
+            PushIncoming(shard, incoming);
+            received = true;
+
+            // anything else that already arrived, without waiting again
+            res = enet_host_check_events(shard.host, &event);
+        }
+
+        if (received)
         {
-            // error occured
-            
-            break;
-        } 
-        else 
+            // taking the lock orders this with a Poll() that just found the
+            // queues empty and is about to wait
+            {
+                std::lock_guard<std::mutex> lock(m_doorbellMutex);
+            }
+            m_doorbell.notify_one();
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= shard.nextStatsSample)
         {
-            // no event
-            break;
+            SampleStats(shard);
+            shard.nextStatsSample = now + STATS_SAMPLE_INTERVAL;
         }
+
+        WaitIO(shard);
     }
-    return msgs;
+
+    // whatever was flushed before stopping still goes out
+    SendOutgoing(shard);
+    enet_host_flush(shard.host);
+}
+
+void ENetServer::WaitIO(Shard& shard)
+{
+    ENetSocketSet readSet;
+    ENET_SOCKETSET_EMPTY(readSet);
+    ENET_SOCKETSET_ADD(readSet, shard.host->socket);
+    ENET_SOCKETSET_ADD(readSet, shard.wakeSocket);
+    enet_socketset_select(std::max(shard.host->socket, shard.wakeSocket), &readSet, nullptr,
+        GetServiceTimeout(shard));
+}
+
+uint32_t ENetServer::GetServiceTimeout(const Shard& shard) const
+{
+    if (!shard.incomingBacklog.empty())
+    {
+        return BACKLOG_RETRY_MS;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    uint32_t timeout = 0;
+    if (shard.nextStatsSample > now)
+    {
+        // rounded up, waking a little early would only spin until it's time
+        auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(shard.nextStatsSample - now).count();
+        timeout = static_cast<uint32_t>((remaining + 999) / 1000);
+    }
+    return ENetTiming::GetServiceTimeout(shard.host, timeout);
+}
+
+void ENetServer::SendOutgoing(Shard& shard)
+{
+    OutgoingPacket outgoing;
+    while (shard.outgoing.TryPop(outgoing))
+    {
+        size_t length = outgoing.packet->dataLength;
+        if (outgoing.broadcast)
+        {
+            enet_host_broadcast(shard.host, outgoing.channel, outgoing.packet);
+            shard.rates.CountSentToAll(length);
+            continue;
+        }
+
+        auto client = shard.clients.find(outgoing.peerId);
+        if (client == shard.clients.end() || enet_peer_send(client->second, outgoing.channel, outgoing.packet) < 0)
+        {
+            // the client left while the packet was on its way
+            enet_packet_destroy(outgoing.packet);
+            continue;
+        }
+        shard.rates.CountSent(outgoing.peerId, length);
+    }
+}
+
+void ENetServer::PushIncoming(Shard& shard, const IncomingEvent& event)
+{
+    if (!shard.incomingBacklog.empty() || !shard.incoming.TryPush(event))
+    {
+        shard.incomingBacklog.push_back(event);
+    }
+}
+
+void ENetServer::SampleStats(Shard& shard)
+{
+    ENetHost* host = shard.host;
+
+    auto now = std::chrono::steady_clock::now();
+    uint32_t elapsedMs = static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - shard.lastStatsSample).count());
+    shard.lastStatsSample = now;
+
+    std::lock_guard<std::mutex> lock(shard.statsMutex);
+    Stats& stats = shard.stats;
+
+    // the host's own counters are 32 bit, move them into ours before they
+    // can wrap
+    stats.packetsSent += host->totalSentPackets;
+    stats.bytesSent += host->totalSentData;
+    stats.packetsReceived += host->totalReceivedPackets;
+    stats.bytesReceived += host->totalReceivedData;
+    host->totalSentPackets = 0;
+    host->totalSentData = 0;
+    host->totalReceivedPackets = 0;
+    host->totalReceivedData = 0;
+
+    stats.peers.clear();
+    for (const auto& iter : shard.clients)
+    {
+        ENetPeer* peer = iter.second;
+
+        PeerStats peerStats;
+        peerStats.id = GetClientID(shard, iter.first);
+        peerStats.roundTripTime = peer->roundTripTime;
+        peerStats.packetLoss = static_cast<float>(peer->packetLoss) / ENET_PEER_PACKET_LOSS_SCALE;
+        peerStats.packetThrottle = peer->packetThrottle;
+        peerStats.reliableDataInTransit = peer->reliableDataInTransit;
+        peerStats.queuedCommands = enet_list_size(&peer->outgoingCommands) + enet_list_size(&peer->sentReliableCommands);
+
+        RateController::Sample sample;
+        sample.roundTripTime = peer->roundTripTime;
+        sample.packetsSent = peer->packetsSent;
+        sample.packetsLost = peer->packetsLost;
+        sample.packetThrottle = peer->packetThrottle;
+        sample.queuedCommands = peerStats.queuedCommands;
+        if (shard.rates.Update(iter.first, sample, elapsedMs))
+        {
+            uint32_t sendInterval = shard.rates.GetSendInterval(iter.first);
+            shard.sendIntervals[iter.first].store(sendInterval, std::memory_order_relaxed);
+            enet_peer_throttle_configure(peer, PEER_THROTTLE_INTERVAL_MS, ENET_PEER_PACKET_THROTTLE_ACCELERATION,
+                std::min(PEER_THROTTLE_DECELERATION * sendInterval, static_cast<uint32_t>(ENET_PEER_PACKET_THROTTLE_SCALE)));
+        }
+        peerStats.sendInterval = shard.rates.GetSendInterval(iter.first);
+        peerStats.bandwidth = shard.rates.GetBandwidth(iter.first);
+        stats.peers.push_back(peerStats);
+    }
+}
+
+void ENetServer::AddPeer(Shard& shard, uint32_t peerId, ENetPeer* peer)
+{
+    shard.clients[peerId] = peer;
+    shard.rates.AddPeer(peerId);
+    shard.sendIntervals[peerId].store(1, std::memory_order_relaxed);
+    enet_peer_throttle_configure(peer, PEER_THROTTLE_INTERVAL_MS, ENET_PEER_PACKET_THROTTLE_ACCELERATION,
+        PEER_THROTTLE_DECELERATION);
+}
+
+void ENetServer::RemovePeer(Shard& shard, uint32_t peerId)
+{
+    shard.clients.erase(peerId);
+    shard.rates.RemovePeer(peerId);
+    shard.sendIntervals[peerId].store(1, std::memory_order_relaxed);
 }
@@ -2,39 +2,226 @@
 
 #include "NetCommon.h"
 #include "Message.h"
+#include "MpscQueue.h"
+#include "PacketCompression.h"
+#include "RateController.h"
+#include "SendQueue.h"
+#include "SpscQueue.h"
 
 #include <enet/enet.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <iostream>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 
+// Clients are spread over one or more shards, each an ENetHost on its own
+// port (base port + shard index) serviced by its own I/O thread. The I/O
+// threads do nothing but service their host, so acks, pings and resends
+// keep their timing however long the game logic takes. Received events
+// reach the thread calling Poll() through lock-free queues, and packets to
+// send go back through others any thread may push to. An I/O thread sleeps
+// on its host's socket until something arrives, a packet is pushed or ENet
+// has to resend or ping.
+// Client ids are unique across shards, game code never sees which shard a
+// client is on.
+// The I/O threads also watch how every client's link copes, tune ENet's
+// throttle to it and tell through GetSendInterval() how often the client
+// should get a snapshot, so a weak link is sent less instead of queueing up
+// until it times out.
+// Everything but Send(id, channel, packet) and GetSendInterval() must be
+// called from the thread that calls Poll()
 class ENetServer
 {
 
 public:
+    // ENet can't address more peers than this on a single host
+    static const uint32_t MAX_PEERS_PER_SHARD = ENET_PROTOCOL_MAXIMUM_PEER_ID;
+
+    struct PeerStats
+    {
+        uint32_t id;
+        // ENet's running estimates, in milliseconds and as a 0-1 ratio
+        uint32_t roundTripTime;
+        float packetLoss;
+        // out of ENET_PEER_PACKET_THROTTLE_SCALE, lower means ENet is
+        // dropping more unreliable packets to this peer
+        uint32_t packetThrottle;
+        // reliable bytes sent but not yet acknowledged
+        uint32_t reliableDataInTransit;
+        // commands waiting to be sent or acknowledged
+        size_t queuedCommands;
+        // the rate controller's verdict, see GetSendInterval(), and the
+        // bandwidth in bytes per second it last saw the link take, 0 if
+        // it never filled up
+        uint32_t sendInterval;
+        uint32_t bandwidth;
+    };
+
+    struct Stats
+    {
+        // UDP packets and bytes since Start(), over all shards
+        uint64_t packetsSent = 0;
+        uint64_t bytesSent = 0;
+        uint64_t packetsReceived = 0;
+        uint64_t bytesReceived = 0;
+        // packets thrown away because an I/O thread fell too far behind
+        uint64_t packetsDropped = 0;
+        std::vector<PeerStats> peers;
+    };
+
     ENetServer();
     ~ENetServer();
 
-    bool Start(uint32_t);
-    bool Stop();
+    // maxPeers is split evenly over the shards, fails if that leaves a
+    // shard with more than MAX_PEERS_PER_SHARD or a port can't be bound.
+    // outgoingBandwidth is in bytes per second for the whole server, also
+    // split over the shards, 0 doesn't limit it
+    bool Start(uint32_t port, uint32_t maxPeers = 64, uint32_t shardCount = 1, const std::string& bindAddress = "localhost",
+        uint32_t outgoingBandwidth = 0);
+    // drains the clients: whatever is queued still goes out, then every
+    // client has TIMEOUT_MS to acknowledge its disconnection while new
+    // connections are turned away. The ids of those that didn't are added
+    // to timedOut, and they are dropped anyway
+    bool Stop(std::vector<uint32_t>* timedOut = nullptr);
     bool IsRunning() const;
 
+    // every shard's host compresses with this from the next Start() on,
+    // clients have to use the same. Fails while running, the hosts belong
+    // to the I/O threads then
+    bool SetCompression(PacketCompression::Type compression);
+
     uint32_t NumClients() const;
+    uint32_t NumShards() const;
+
+    // both only queue the message, nothing goes out until Flush()
+    void Send(uint32_t, DeliveryType, const std::string& messageStr);
+    void Send(uint32_t, DeliveryType, const uint8_t* data, size_t length);
+    // sends a packet that was already batched elsewhere, such as by a room
+    // on a worker thread, and takes ownership of it. Safe from any thread
+    void Send(uint32_t, uint8_t channel, ENetPacket* packet);
+    void Broadcast(DeliveryType, const std::string& messageStr);
+    void Broadcast(DeliveryType, const uint8_t* data, size_t length);
 
-    void Send(uint32_t, DeliveryType, const std::string& messageStr) const;
-    void Broadcast(DeliveryType, const std::string& messageStr) const;
-    std::vector<Message> Poll();
+    // encodes a message straight into the client's outgoing packet: write
+    // up to maxLength bytes to the returned buffer, then CommitSend() the
+    // length used. Returns nullptr if there is no such client
+    uint8_t* BeginSend(uint32_t, DeliveryType, size_t maxLength);
+    void CommitSend(uint32_t, size_t length);
+    // hands everything queued since the last flush to the I/O threads,
+    // once per tick
+    void Flush();
+    // waits up to timeoutMs for an I/O thread to receive something and
+    // returns every event received so far as soon as there is one. A zero
+    // timeout only drains what already arrived
+    std::vector<Message> Poll(uint32_t timeoutMs = 0);
+    // makes a Poll() waiting on another thread return now, or the next one
+    // return without waiting. Safe from any thread
+    void InterruptPoll();
+
+    // as last sampled by the I/O threads, a few times a second
+    void GetStats(Stats& stats) const;
+
+    // a snapshot should go to the client every this many ticks, 1 unless
+    // its link can't keep up. Safe from any thread
+    uint32_t GetSendInterval(uint32_t id) const;
 
 private:
-    ENetPeer* GetClient(uint32_t) const;
+    struct IncomingEvent
+    {
+        ENetEventType type;
+        // id within the shard
+        uint32_t peerId;
+        ENetPacket* packet;
+    };
+
+    struct OutgoingPacket
+    {
+        // broadcasts go to every connected client of the shard
+        bool broadcast;
+        uint32_t peerId;
+        uint8_t channel;
+        ENetPacket* packet;
+    };
+
+    struct Shard
+    {
+        Shard(uint32_t index, ENetHost* host, ENetSocket wakeSocket, const ENetAddress& wakeAddress, uint32_t peerCount);
+
+        uint32_t index;
+        ENetHost* host;
+        // NOTE: ENet allocates all peers at once and doesn't shuffle them,
+        // which leads to non-contiguous connected peers. This map
+        // will make it easier to manage them by id
+        // NOTE: owned by the I/O thread while it runs
+        std::map<uint32_t, ENetPeer*> clients;
+
+        std::thread ioThread;
+        std::atomic<bool> ioRunning;
+
+        SpscQueue<IncomingEvent> incoming;
+        MpscQueue<OutgoingPacket> outgoing;
+        // events the I/O thread received while incoming was full
+        std::deque<IncomingEvent> incomingBacklog;
+        std::atomic<uint64_t> droppedPackets;
+
+        // a loopback socket the I/O thread waits on along with the host's.
+        // Pushing a packet sends it a byte, unless one is already pending
+        ENetSocket wakeSocket;
+        ENetAddress wakeAddress;
+        std::atomic<bool> wakePending;
+
+        // sampled from the host by the I/O thread
+        mutable std::mutex statsMutex;
+        Stats stats;
+        std::chrono::steady_clock::time_point lastStatsSample;
+        std::chrono::steady_clock::time_point nextStatsSample;
+
+        // fed by the I/O thread with every sample, its send intervals are
+        // published by peer id for the rooms to read
+        RateController rates;
+        std::unique_ptr<std::atomic<uint32_t>[]> sendIntervals;
+    };
+
+    uint32_t GetClientID(const Shard& shard, uint32_t peerId) const;
+    Shard* GetShard(uint32_t id) const;
+
+    void PushOutgoing(Shard& shard, const OutgoingPacket& outgoing);
+    void Wake(Shard& shard);
+    void HandleIncoming(const Shard& shard, const IncomingEvent& event, std::vector<Message>& msgs);
+    bool HasIncoming() const;
+    void StopIO(Shard& shard);
+    bool DisconnectAll(std::vector<uint32_t>* timedOut);
+    void DestroyShards();
+
+    // I/O thread only
+    void RunIO(Shard& shard);
+    void WaitIO(Shard& shard);
+    uint32_t GetServiceTimeout(const Shard& shard) const;
+    void SendOutgoing(Shard& shard);
+    void PushIncoming(Shard& shard, const IncomingEvent& event);
+    void SampleStats(Shard& shard);
+    void AddPeer(Shard& shard, uint32_t peerId, ENetPeer* peer);
+    void RemovePeer(Shard& shard, uint32_t peerId);
+
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    uint32_t m_peersPerShard;
+    PacketCompression::Type m_compression;
 
-    ENetHost* m_host;
-    // NOTE: ENet allocates all peers at once and doesn't shuffle them,
-    // which leads to non-contiguous connected peers. This map
-    // will make it easier to manage them by id
-    std::map<uint32_t, ENetPeer*> m_clients;
+    // clients as last seen by Poll(), with what is queued for them
+    std::map<uint32_t, SendQueue> m_sendQueues;
+    SendQueue m_broadcastQueue;
 
-    static char MESSAGE_BUFFER[MAX_MESSAGE_LEN];
+    // rung by an I/O thread whenever it queued events, Poll() waits on it
+    std::mutex m_doorbellMutex;
+    std::condition_variable m_doorbell;
+    // guarded by m_doorbellMutex
+    bool m_pollInterrupted;
 };
@@ -0,0 +1,101 @@
+#include "InterestGrid.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+InterestGrid::InterestGrid(int cellSize)
+    : m_cellSize(cellSize > 0 ? cellSize : 1)
+{
+}
+
+void InterestGrid::Set(uint32_t id, int x, int y)
+{
+    uint64_t cell = GetCellKey(GetCellCoordinate(x), GetCellCoordinate(y));
+
+    auto iter = m_entries.find(id);
+    if (iter != m_entries.end())
+    {
+        iter->second.x = x;
+        iter->second.y = y;
+        if (iter->second.cell == cell)
+        {
+            return;
+        }
+        Remove(id);
+    }
+
+    Entry entry;
+    entry.x = x;
+    entry.y = y;
+    entry.cell = cell;
+    m_entries[id] = entry;
+    m_cells[cell].push_back(id);
+}
+
+void InterestGrid::Remove(uint32_t id)
+{
+    auto iter = m_entries.find(id);
+    if (iter == m_entries.end())
+    {
+        return;
+    }
+
+    auto cell = m_cells.find(iter->second.cell);
+    if (cell != m_cells.end())
+    {
+        // order inside a cell doesn't matter, swap with the last one
+        std::vector<uint32_t>& ids = cell->second;
+        auto found = std::find(ids.begin(), ids.end(), id);
+        if (found != ids.end())
+        {
+            *found = ids.back();
+            ids.pop_back();
+        }
+        if (ids.empty())
+        {
+            m_cells.erase(cell);
+        }
+    }
+
+    m_entries.erase(iter);
+}
+
+void InterestGrid::Query(int x, int y, int radius, std::vector<uint32_t>& result) const
+{
+    int minCellX = GetCellCoordinate(x - radius);
+    int maxCellX = GetCellCoordinate(x + radius);
+    int minCellY = GetCellCoordinate(y - radius);
+    int maxCellY = GetCellCoordinate(y + radius);
+
+    for (int cellY = minCellY; cellY <= maxCellY; ++cellY)
+    {
+        for (int cellX = minCellX; cellX <= maxCellX; ++cellX)
+        {
+            auto cell = m_cells.find(GetCellKey(cellX, cellY));
+            if (cell == m_cells.end())
+            {
+                continue;
+            }
+
+            for (uint32_t id : cell->second)
+            {
+                const Entry& entry = m_entries.at(id);
+                if (abs(entry.x - x) <= radius && abs(entry.y - y) <= radius)
+                {
+                    result.push_back(id);
+                }
+            }
+        }
+    }
+}
+
+uint64_t InterestGrid::GetCellKey(int cellX, int cellY) const
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cellX)) << 32) | static_cast<uint32_t>(cellY);
+}
+
+int InterestGrid::GetCellCoordinate(int position) const
+{
+    // rounds towards negative infinity so cells don't double up around 0
+    return position >= 0 ? position / m_cellSize : -((-position - 1) / m_cellSize) - 1;
+}
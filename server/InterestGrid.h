@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Spatial hash over level tiles. Each entry lives in the cell covering its
+// position, so finding what is near a point only touches the handful of
+// cells around it instead of every entry
+class InterestGrid
+{
+
+public:
+    explicit InterestGrid(int cellSize);
+
+    void Set(uint32_t id, int x, int y);
+    void Remove(uint32_t id);
+
+    // appends every entry within radius tiles of (x, y) on both axes to
+    // result, in no particular order
+    void Query(int x, int y, int radius, std::vector<uint32_t>& result) const;
+
+private:
+    struct Entry
+    {
+        int x;
+        int y;
+        uint64_t cell;
+    };
+
+    uint64_t GetCellKey(int cellX, int cellY) const;
+    int GetCellCoordinate(int position) const;
+
+    int m_cellSize;
+
+    std::unordered_map<uint64_t, std::vector<uint32_t>> m_cells;
+    std::unordered_map<uint32_t, Entry> m_entries;
+};
@@ -0,0 +1,255 @@
+#include "PositionRelay.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+static bool HasSameState(const Protocol::Snapshot& a, const Protocol::Snapshot& b)
+{
+    if (a.hasSelf != b.hasSelf || a.selfX != b.selfX || a.selfY != b.selfY || a.inputSequence != b.inputSequence)
+    {
+        return false;
+    }
+    if (a.players.size() != b.players.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < a.players.size(); ++i)
+    {
+        if (a.players[i].peerId != b.players[i].peerId || a.players[i].x != b.players[i].x || a.players[i].y != b.players[i].y)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+PositionRelay::PeerState::PeerState()
+    : hasPosition(false)
+    , x(0)
+    , y(0)
+    , inputSequence(Protocol::NO_INPUT)
+    , nextSequence(Protocol::NO_BASELINE + 1)
+    , ackedSequence(Protocol::NO_BASELINE)
+{
+}
+
+PositionRelay::PositionRelay(uint32_t roomId, int viewRadius, int hysteresis)
+    : m_viewRadius(viewRadius > 0 ? viewRadius : 0)
+    , m_hysteresis(hysteresis > 0 ? hysteresis : 0)
+    // a query then covers at most 3x3 cells
+    , m_grid(m_viewRadius + m_hysteresis)
+{
+    m_bits.x = 1;
+    m_bits.y = 1;
+    m_snapshot.roomId = roomId;
+}
+
+void PositionRelay::AddPeer(uint32_t peerId)
+{
+    // a reused peer id starts over with a fresh snapshot history
+    m_peers.erase(peerId);
+    m_peers[peerId];
+}
+
+void PositionRelay::RemovePeer(uint32_t peerId)
+{
+    m_peers.erase(peerId);
+    m_grid.Remove(peerId);
+}
+
+void PositionRelay::SetPosition(uint32_t peerId, int x, int y, Protocol::CoordinateBits bits)
+{
+    auto iter = m_peers.find(peerId);
+    if (iter == m_peers.end())
+    {
+        return;
+    }
+
+    if (bits.x > m_bits.x)
+    {
+        m_bits.x = bits.x;
+    }
+    if (bits.y > m_bits.y)
+    {
+        m_bits.y = bits.y;
+    }
+
+    iter->second.hasPosition = true;
+    iter->second.x = x;
+    iter->second.y = y;
+    m_grid.Set(peerId, x, y);
+}
+
+bool PositionRelay::GetPosition(uint32_t peerId, int& x, int& y) const
+{
+    auto iter = m_peers.find(peerId);
+    if (iter == m_peers.end() || !iter->second.hasPosition)
+    {
+        return false;
+    }
+
+    x = iter->second.x;
+    y = iter->second.y;
+    return true;
+}
+
+uint32_t PositionRelay::GetInputSequence(uint32_t peerId) const
+{
+    auto iter = m_peers.find(peerId);
+    return iter != m_peers.end() ? iter->second.inputSequence : Protocol::NO_INPUT;
+}
+
+void PositionRelay::SetInputSequence(uint32_t peerId, uint32_t sequence)
+{
+    auto iter = m_peers.find(peerId);
+    if (iter != m_peers.end())
+    {
+        iter->second.inputSequence = sequence;
+    }
+}
+
+void PositionRelay::AcknowledgeSnapshot(uint32_t peerId, uint32_t sequence)
+{
+    auto iter = m_peers.find(peerId);
+    if (iter == m_peers.end())
+    {
+        return;
+    }
+
+    // acks arrive unreliably and out of order, only ever move forward and
+    // never past what was actually sent
+    PeerState& state = iter->second;
+    if (sequence > state.ackedSequence && sequence < state.nextSequence)
+    {
+        state.ackedSequence = sequence;
+    }
+}
+
+std::vector<uint32_t> PositionRelay::GetPeers() const
+{
+    std::vector<uint32_t> peers;
+    peers.reserve(m_peers.size());
+    for (const auto& iter : m_peers)
+    {
+        peers.push_back(iter.first);
+    }
+    return peers;
+}
+
+size_t PositionRelay::GetMaxSnapshotSize(uint32_t recipientId) const
+{
+    size_t baselineSize = 0;
+    auto iter = m_peers.find(recipientId);
+    if (iter != m_peers.end())
+    {
+        const Protocol::Snapshot* baseline = iter->second.sent.Find(iter->second.ackedSequence);
+        if (baseline != nullptr)
+        {
+            baselineSize = baseline->players.size();
+        }
+    }
+    return Protocol::GetMaxSnapshotSize(m_peers.size(), baselineSize);
+}
+
+size_t PositionRelay::BuildSnapshot(uint32_t recipientId, uint32_t serverTime, uint8_t* buffer, size_t capacity)
+{
+    auto recipient = m_peers.find(recipientId);
+    if (recipient == m_peers.end())
+    {
+        return 0;
+    }
+    PeerState& state = recipient->second;
+
+    m_snapshot.hasSelf = state.hasPosition;
+    m_snapshot.selfX = state.x;
+    m_snapshot.selfY = state.y;
+    m_snapshot.inputSequence = state.inputSequence;
+
+    m_snapshot.players.clear();
+    if (m_viewRadius > 0)
+    {
+        AddVisiblePlayers(recipientId, state);
+    }
+    else
+    {
+        AddAllPlayers(recipientId);
+    }
+
+    // falls back to a full snapshot when nothing was acknowledged yet or the
+    // acknowledged one is too old to still be in the history
+    const Protocol::Snapshot* baseline = state.sent.Find(state.ackedSequence);
+    if (baseline != nullptr && HasSameState(*baseline, m_snapshot))
+    {
+        // the client already has all of this
+        return 0;
+    }
+    if (state.nextSequence == Protocol::NO_BASELINE + 1 && !m_snapshot.hasSelf && m_snapshot.players.empty())
+    {
+        // nothing to tell a client that has never heard from us
+        return 0;
+    }
+
+    m_snapshot.sequence = state.nextSequence++;
+    m_snapshot.serverTime = serverTime;
+    size_t length = Protocol::EncodeSnapshot(m_snapshot, baseline, m_bits, buffer, capacity);
+    if (length > 0)
+    {
+        state.sent.Store(m_snapshot);
+    }
+    return length;
+}
+
+void PositionRelay::AddVisiblePlayers(uint32_t recipientId, PeerState& recipient)
+{
+    m_visible.clear();
+
+    // until it reports where it is a peer can't see anyone
+    if (recipient.hasPosition)
+    {
+        m_nearby.clear();
+        m_grid.Query(recipient.x, recipient.y, m_viewRadius + m_hysteresis, m_nearby);
+
+        // snapshots list players sorted by id
+        std::sort(m_nearby.begin(), m_nearby.end());
+
+        for (uint32_t peerId : m_nearby)
+        {
+            if (peerId == recipientId)
+            {
+                continue;
+            }
+
+            const PeerState& other = m_peers.at(peerId);
+            bool inRadius = abs(other.x - recipient.x) <= m_viewRadius && abs(other.y - recipient.y) <= m_viewRadius;
+            if (!inRadius && !std::binary_search(recipient.visible.begin(), recipient.visible.end(), peerId))
+            {
+                continue;
+            }
+
+            AddPlayer(peerId, other);
+            m_visible.push_back(peerId);
+        }
+    }
+
+    recipient.visible.swap(m_visible);
+}
+
+void PositionRelay::AddAllPlayers(uint32_t recipientId)
+{
+    for (const auto& iter : m_peers)
+    {
+        if (iter.first != recipientId && iter.second.hasPosition)
+        {
+            AddPlayer(iter.first, iter.second);
+        }
+    }
+}
+
+void PositionRelay::AddPlayer(uint32_t peerId, const PeerState& state)
+{
+    Protocol::PlayerPosition player;
+    player.peerId = peerId;
+    player.x = state.x;
+    player.y = state.y;
+    m_snapshot.players.push_back(player);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "InterestGrid.h"
+#include "Protocol.h"
+#include "SnapshotHistory.h"
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+// Keeps the position of every connected peer during a tick and builds the
+// snapshot each peer receives at the end of it, so the send phase emits one
+// packet per recipient instead of one per update. Each snapshot also tells
+// the recipient where it is itself and which of its inputs that includes.
+// Snapshots are deltas against the last one the recipient acknowledged,
+// which keeps steady state traffic proportional to what moved and lets
+// them go out unreliably: a lost delta is simply covered by the next one.
+// With a view radius set, a peer only hears about players within that many
+// tiles of it, so traffic grows with local density rather than with the
+// square of the player count. Players already in view stay in it until they
+// are hysteresis tiles past the radius, so someone walking along the edge
+// doesn't flicker in and out
+class PositionRelay
+{
+
+public:
+    // a viewRadius of 0 sends everyone to everyone
+    PositionRelay(uint32_t roomId, int viewRadius, int hysteresis);
+
+    void AddPeer(uint32_t peerId);
+    void RemovePeer(uint32_t peerId);
+    void SetPosition(uint32_t peerId, int x, int y, Protocol::CoordinateBits bits);
+    // false until the peer was given a position
+    bool GetPosition(uint32_t peerId, int& x, int& y) const;
+    // newest input of the peer that was applied, Protocol::NO_INPUT if
+    // there is no such peer
+    uint32_t GetInputSequence(uint32_t peerId) const;
+    void SetInputSequence(uint32_t peerId, uint32_t sequence);
+    void AcknowledgeSnapshot(uint32_t peerId, uint32_t sequence);
+
+    std::vector<uint32_t> GetPeers() const;
+
+    size_t GetMaxSnapshotSize(uint32_t recipientId) const;
+
+    // encodes the recipient's own state and every other peer with a known
+    // position into buffer, stamped with serverTime. Returns the encoded
+    // length or 0 if the recipient is up to date (or it didn't fit)
+    size_t BuildSnapshot(uint32_t recipientId, uint32_t serverTime, uint8_t* buffer, size_t capacity);
+
+private:
+    struct PeerState
+    {
+        PeerState();
+
+        bool hasPosition;
+        int x;
+        int y;
+        uint32_t inputSequence;
+
+        uint32_t nextSequence;
+        uint32_t ackedSequence;
+        SnapshotHistory sent;
+
+        // peers in the last snapshot built for this one, sorted
+        std::vector<uint32_t> visible;
+    };
+
+    void AddVisiblePlayers(uint32_t recipientId, PeerState& recipient);
+    void AddAllPlayers(uint32_t recipientId);
+    void AddPlayer(uint32_t peerId, const PeerState& state);
+
+    std::map<uint32_t, PeerState> m_peers;
+
+    int m_viewRadius;
+    int m_hysteresis;
+    InterestGrid m_grid;
+
+    // widest coordinates any peer reported, snapshots are encoded with these
+    Protocol::CoordinateBits m_bits;
+
+    // reused between recipients to avoid allocating per snapshot
+    Protocol::Snapshot m_snapshot;
+    std::vector<uint32_t> m_nearby;
+    std::vector<uint32_t> m_visible;
+};
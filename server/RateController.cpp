@@ -0,0 +1,177 @@
+#include "RateController.h"
+
+#include <enet/enet.h>
+
+#include <algorithm>
+
+// fewer packets than this in a sample don't tell the loss apart from luck
+const uint32_t MIN_LOSS_PACKETS = 8;
+const float MAX_PACKET_LOSS = 0.05f;
+// round trip time above the lowest one seen, in milliseconds, that is
+// taken for packets queueing up somewhere on the way
+const uint32_t MAX_QUEUE_DELAY_MS = 100;
+// the lowest round trip time creeps up by this much every sample, so a
+// route that got slower for good isn't taken for a queue forever
+const uint32_t MIN_ROUND_TRIP_DRIFT_MS = 1;
+const size_t MAX_QUEUED_COMMANDS = 128;
+// below this ENet is dropping a good share of the unreliable packets
+const uint32_t MIN_PACKET_THROTTLE = ENET_PEER_PACKET_THROTTLE_SCALE * 3 / 4;
+// samples to wait after slowing a peer down before slowing it further,
+// the packets already queued need to drain first
+const uint32_t HOLD_SAMPLES = 2;
+// samples without trouble before a peer is sent snapshots more often. It
+// doubles, up to the most, every time that turned out too much for the link
+const uint32_t RECOVERY_SAMPLES = 8;
+const uint32_t MAX_RECOVERY_SAMPLES = 128;
+// share of the bandwidth seen that a peer is allowed to use
+const float BANDWIDTH_HEADROOM = 0.8f;
+// the bandwidth seen grows by 1/N every sample without trouble
+const uint32_t BANDWIDTH_PROBE_DIVISOR = 16;
+
+const uint32_t RateController::MAX_SEND_INTERVAL;
+
+RateController::RateController()
+{
+}
+
+void RateController::AddPeer(uint32_t peerId)
+{
+    PeerState state;
+    state.recoverySamples = RECOVERY_SAMPLES;
+    m_peers[peerId] = state;
+}
+
+void RateController::RemovePeer(uint32_t peerId)
+{
+    m_peers.erase(peerId);
+}
+
+void RateController::CountSent(uint32_t peerId, size_t bytes)
+{
+    auto iter = m_peers.find(peerId);
+    if (iter != m_peers.end())
+    {
+        iter->second.bytesSent += static_cast<uint32_t>(bytes);
+    }
+}
+
+void RateController::CountSentToAll(size_t bytes)
+{
+    for (auto& iter : m_peers)
+    {
+        iter.second.bytesSent += static_cast<uint32_t>(bytes);
+    }
+}
+
+bool RateController::Update(uint32_t peerId, const Sample& sample, uint32_t elapsedMs)
+{
+    auto iter = m_peers.find(peerId);
+    if (iter == m_peers.end())
+    {
+        return false;
+    }
+    PeerState& state = iter->second;
+
+    // smaller counters than last time mean ENet started them over
+    uint32_t sent = sample.packetsSent >= state.packetsSent ? sample.packetsSent - state.packetsSent : sample.packetsSent;
+    uint32_t lost = sample.packetsLost >= state.packetsLost ? sample.packetsLost - state.packetsLost : sample.packetsLost;
+    state.packetsSent = sample.packetsSent;
+    state.packetsLost = sample.packetsLost;
+
+    uint64_t rate = elapsedMs > 0 ? static_cast<uint64_t>(state.bytesSent) * 1000 / elapsedMs : 0;
+    state.bytesSent = 0;
+
+    if (state.minRoundTripTime == 0)
+    {
+        state.minRoundTripTime = sample.roundTripTime;
+    }
+    state.minRoundTripTime = std::min(state.minRoundTripTime + MIN_ROUND_TRIP_DRIFT_MS, sample.roundTripTime);
+
+    state.heldSamples++;
+    uint32_t interval = state.sendInterval;
+    if (IsCongested(state, sample, sent, lost))
+    {
+        state.cleanSamples = 0;
+
+        // what got through is about what the link has room for
+        float loss = sent > 0 ? static_cast<float>(lost) / sent : 0.0f;
+        uint32_t delivered = static_cast<uint32_t>(rate * (1.0f - std::min(loss, 1.0f)));
+        if (delivered > 0)
+        {
+            state.bandwidth = delivered;
+        }
+
+        if (state.heldSamples >= HOLD_SAMPLES && interval < MAX_SEND_INTERVAL)
+        {
+            // enough fewer snapshots to fit what got through, with some
+            // room to spare, and at least one step fewer
+            uint32_t target = interval + 1;
+            if (state.bandwidth > 0)
+            {
+                double fit = static_cast<double>(interval) * rate / (state.bandwidth * BANDWIDTH_HEADROOM);
+                target = std::max(target, static_cast<uint32_t>(std::min(fit + 0.999, static_cast<double>(MAX_SEND_INTERVAL))));
+            }
+            interval = std::min(target, MAX_SEND_INTERVAL);
+            if (state.probing)
+            {
+                state.recoverySamples = std::min(state.recoverySamples * 2, MAX_RECOVERY_SAMPLES);
+                state.probing = false;
+            }
+        }
+    }
+    else if (interval > 1)
+    {
+        state.cleanSamples++;
+
+        // one step at a time, if the peer would still fit what its link
+        // took so far, which is given the benefit of the doubt until it does
+        uint64_t projected = rate * interval / (interval - 1);
+        if (state.bandwidth > 0 && projected > state.bandwidth * BANDWIDTH_HEADROOM)
+        {
+            state.bandwidth += std::max(state.bandwidth / BANDWIDTH_PROBE_DIVISOR, 1u);
+        }
+        if (state.cleanSamples >= state.recoverySamples
+            && (state.bandwidth == 0 || projected <= state.bandwidth * BANDWIDTH_HEADROOM))
+        {
+            // the last step up held, the link took it
+            if (state.probing)
+            {
+                state.recoverySamples = RECOVERY_SAMPLES;
+            }
+            state.probing = true;
+            interval--;
+        }
+    }
+
+    if (interval == state.sendInterval)
+    {
+        return false;
+    }
+    state.sendInterval = interval;
+    state.heldSamples = 0;
+    state.cleanSamples = 0;
+    return true;
+}
+
+uint32_t RateController::GetSendInterval(uint32_t peerId) const
+{
+    auto iter = m_peers.find(peerId);
+    return iter != m_peers.end() ? iter->second.sendInterval : 1;
+}
+
+uint32_t RateController::GetBandwidth(uint32_t peerId) const
+{
+    auto iter = m_peers.find(peerId);
+    return iter != m_peers.end() ? iter->second.bandwidth : 0;
+}
+
+bool RateController::IsCongested(const PeerState& state, const Sample& sample, uint32_t sent, uint32_t lost) const
+{
+    if (sent >= MIN_LOSS_PACKETS && static_cast<float>(lost) / sent > MAX_PACKET_LOSS)
+    {
+        return true;
+    }
+    return sample.roundTripTime > state.minRoundTripTime + MAX_QUEUE_DELAY_MS
+        || sample.queuedCommands > MAX_QUEUED_COMMANDS
+        || sample.packetThrottle < MIN_PACKET_THROTTLE;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+
+// Decides how often each peer is sent snapshots from how its link copes
+// with what it's sent. A few times a second it gets a sample of every
+// peer's connection: losses, round trip time, the commands piling up in
+// ENet and whether ENet's own throttle is dropping packets. Any of those
+// going bad means the link is full, the bandwidth that got through is
+// remembered and the peer gets snapshots less often until it fits. After a
+// while without trouble it's sent them more often again, one step at a
+// time, as long as the higher rate fits the bandwidth seen so far, which
+// creeps up in the meantime so a link that got better is found out. A step
+// up the link couldn't take makes it wait twice as long before the next.
+// Only the thread that owns the peers calls into it
+class RateController
+{
+
+public:
+    // snapshots go out every this many ticks at most
+    static const uint32_t MAX_SEND_INTERVAL = 8;
+
+    struct Sample
+    {
+        // ENet's smoothed estimate
+        uint32_t roundTripTime;
+        // ENet's counters, which it starts over every
+        // ENET_PEER_PACKET_LOSS_INTERVAL
+        uint32_t packetsSent;
+        uint32_t packetsLost;
+        // out of ENET_PEER_PACKET_THROTTLE_SCALE
+        uint32_t packetThrottle;
+        // commands waiting to be sent or acknowledged
+        size_t queuedCommands;
+    };
+
+    RateController();
+
+    void AddPeer(uint32_t peerId);
+    void RemovePeer(uint32_t peerId);
+
+    // bytes handed to ENet for the peer, counted until its next sample
+    void CountSent(uint32_t peerId, size_t bytes);
+    void CountSentToAll(size_t bytes);
+
+    // elapsedMs since the peer's last sample. Returns true if its send
+    // interval changed
+    bool Update(uint32_t peerId, const Sample& sample, uint32_t elapsedMs);
+
+    // 1 sends a snapshot every tick
+    uint32_t GetSendInterval(uint32_t peerId) const;
+    // in bytes per second, 0 until the peer's link was full once
+    uint32_t GetBandwidth(uint32_t peerId) const;
+
+private:
+    struct PeerState
+    {
+        uint32_t sendInterval = 1;
+        uint32_t bandwidth = 0;
+        uint32_t minRoundTripTime = 0;
+        uint32_t packetsSent = 0;
+        uint32_t packetsLost = 0;
+        uint32_t bytesSent = 0;
+        // samples since the interval last changed, or the link was last full
+        uint32_t heldSamples = 0;
+        uint32_t cleanSamples = 0;
+        uint32_t recoverySamples = 0;
+        // the last change was a step up, trouble now means it was too much
+        bool probing = false;
+    };
+
+    bool IsCongested(const PeerState& state, const Sample& sample, uint32_t sent, uint32_t lost) const;
+
+    std::map<uint32_t, PeerState> m_peers;
+};
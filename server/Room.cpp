@@ -0,0 +1,224 @@
+#include "Room.h"
+
+#include "ENetServer.h"
+
+#include <algorithm>
+#include <utility>
+
+// a client on a weak link is sent fewer snapshots, but never further apart
+// than this in milliseconds, or it can't show anyone moving smoothly anymore
+const uint32_t MAX_SNAPSHOT_GAP_MS = 200;
+
+Room::Room(uint32_t id, uint32_t tickRate, int viewRadius, int hysteresis, std::unique_ptr<Level> level)
+    : m_id(id)
+    , m_playerCount(0)
+    , m_level(std::move(level))
+    , m_bits(Protocol::CoordinateBits::ForLevel(m_level->GetWidth(), m_level->GetHeight()))
+    , m_scheduler(tickRate)
+    , m_maxSendInterval(std::max(tickRate * MAX_SNAPSHOT_GAP_MS / 1000, 1u))
+    , m_relay(id, viewRadius, hysteresis)
+    , m_ticking(false)
+{
+    m_scheduler.Start();
+}
+
+uint32_t Room::GetID() const
+{
+    return m_id;
+}
+
+size_t Room::GetPlayerCount() const
+{
+    return m_playerCount;
+}
+
+void Room::Join(uint32_t peerId)
+{
+    // joining and leaving go through the inbox so they are applied in order
+    // with the player's messages, on the tick
+    m_playerCount++;
+    Deliver(Message(peerId, Message::Type::CONNECT));
+}
+
+void Room::Leave(uint32_t peerId)
+{
+    m_playerCount--;
+    Deliver(Message(peerId, Message::Type::DISCONNECT));
+}
+
+void Room::Deliver(const Message& msg)
+{
+    std::lock_guard<std::mutex> lock(m_inboxMutex);
+    m_inbox.push_back(msg);
+}
+
+bool Room::IsTickDue() const
+{
+    return m_scheduler.IsTickDue();
+}
+
+uint32_t Room::GetTimeUntilNextTick() const
+{
+    return m_scheduler.GetTimeUntilNextTick();
+}
+
+uint32_t Room::BeginTick()
+{
+    m_ticking.store(true, std::memory_order_relaxed);
+    return m_scheduler.Advance();
+}
+
+void Room::Tick(ENetServer& server)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_inboxMutex);
+        m_received.swap(m_inbox);
+    }
+
+    Simulate(m_received);
+    m_received.clear();
+
+    BuildSnapshots(server);
+    Flush(server);
+
+    // publishes the send queues to the network thread
+    m_ticking.store(false, std::memory_order_release);
+}
+
+bool Room::IsTicking() const
+{
+    return m_ticking.load(std::memory_order_acquire);
+}
+
+void Room::Flush(ENetServer& server)
+{
+    for (auto& iter : m_sendQueues)
+    {
+        if (iter.second.IsEmpty())
+        {
+            continue;
+        }
+
+        uint32_t peerId = iter.first;
+        iter.second.Flush([&server, peerId](uint8_t channel, ENetPacket* packet) {
+            server.Send(peerId, channel, packet);
+        });
+    }
+}
+
+void Room::Simulate(const std::vector<Message>& messages)
+{
+    for (const auto& msg : messages)
+    {
+        uint32_t id = msg.GetPeerID();
+
+        switch (msg.GetType())
+        {
+
+            case Message::Type::CONNECT:
+                    m_relay.AddPeer(id);
+                    m_sendQueues[id];
+                    break;
+
+            case Message::Type::DISCONNECT:
+                    m_relay.RemovePeer(id);
+                    m_sendQueues.erase(id);
+                    break;
+
+            case Message::Type::DATA:
+            {
+                    Protocol::MessageType type;
+                    if (!Protocol::ReadType(msg.GetData(), msg.GetDataLength(), type))
+                    {
+                        break;
+                    }
+
+                    if (type == Protocol::MessageType::INPUT)
+                    {
+                        // every message repeats the steps that weren't
+                        // acknowledged yet, ApplyInput() skips the ones
+                        // already applied
+                        Protocol::Input inputs[Protocol::MAX_INPUTS_PER_MESSAGE];
+                        size_t count = 0;
+                        if (Protocol::DecodeInputs(msg.GetData(), msg.GetDataLength(), inputs, count))
+                        {
+                            for (size_t i = 0; i < count; ++i)
+                            {
+                                ApplyInput(id, inputs[i]);
+                            }
+                        }
+                    }
+                    else if (type == Protocol::MessageType::JOIN)
+                    {
+                        uint32_t roomId = 0;
+                        uint32_t inputSequence = 0;
+                        if (Protocol::DecodeJoin(msg.GetData(), msg.GetDataLength(), roomId, inputSequence))
+                        {
+                            Spawn(id, inputSequence);
+                        }
+                    }
+                    else if (type == Protocol::MessageType::SNAPSHOT_ACK)
+                    {
+                        uint32_t sequence = 0;
+                        if (Protocol::DecodeSnapshotAck(msg.GetData(), msg.GetDataLength(), sequence))
+                        {
+                            m_relay.AcknowledgeSnapshot(id, sequence);
+                        }
+                    }
+                    break;
+            }
+        }
+    }
+}
+
+// one aggregated snapshot per player, unreliable since every snapshot is a
+// delta against one the player confirmed it has. Players whose link can't
+// keep up skip ticks, spread so they don't all get theirs on the same one
+void Room::BuildSnapshots(const ENetServer& server)
+{
+    // the time the tick was due rather than when a worker got to it, so
+    // clients only see the network's jitter and not the pool's
+    uint64_t tick = m_scheduler.GetTick() - 1;
+    uint32_t serverTime = static_cast<uint32_t>(tick * 1000 / m_scheduler.GetTickRate());
+
+    for (auto& iter : m_sendQueues)
+    {
+        uint32_t sendInterval = std::min(server.GetSendInterval(iter.first), m_maxSendInterval);
+        if ((tick + iter.first) % sendInterval != 0)
+        {
+            continue;
+        }
+
+        // encoded straight into the player's outgoing packet
+        size_t maxLength = m_relay.GetMaxSnapshotSize(iter.first);
+        uint8_t* buffer = iter.second.Reserve(DeliveryType::UNRELIABLE, maxLength);
+        iter.second.Commit(m_relay.BuildSnapshot(iter.first, serverTime, buffer, maxLength));
+    }
+}
+
+void Room::Spawn(uint32_t peerId, uint32_t inputSequence)
+{
+    // the join used up a sequence of its own, steps taken before it don't
+    // count anymore
+    m_relay.SetPosition(peerId, m_level->GetSpawnX(), m_level->GetSpawnY(), m_bits);
+    m_relay.SetInputSequence(peerId, inputSequence);
+}
+
+void Room::ApplyInput(uint32_t peerId, const Protocol::Input& input)
+{
+    int x = 0;
+    int y = 0;
+    if (!m_relay.GetPosition(peerId, x, y) || input.sequence <= m_relay.GetInputSequence(peerId))
+    {
+        return;
+    }
+
+    // a step into a wall is still acknowledged, the client then replays
+    // its later steps from where the player really is
+    Protocol::Step(input.direction, x, y);
+    if (!m_level->IsWall(x, y))
+    {
+        m_relay.SetPosition(peerId, x, y, m_bits);
+    }
+    m_relay.SetInputSequence(peerId, input.sequence);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Level.h"
+#include "Message.h"
+#include "PositionRelay.h"
+#include "SendQueue.h"
+#include "TickScheduler.h"
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class ENetServer;
+
+// One match: a level, the players in it and its own tick. The room decides
+// where its players are: they send the steps they take and the room applies
+// each one that doesn't run into a wall.
+// Ticks run on a worker thread, so one busy room only delays itself, and
+// hand their packets straight to the server's I/O thread. The thread
+// dispatching messages only touches a room through Deliver() while it is
+// ticking, everything else waits until IsTicking() is false again
+class Room
+{
+
+public:
+    Room(uint32_t id, uint32_t tickRate, int viewRadius, int hysteresis, std::unique_ptr<Level> level);
+
+    uint32_t GetID() const;
+    size_t GetPlayerCount() const;
+
+    // the player's JOIN is delivered after this, it places the player
+    void Join(uint32_t peerId);
+    void Leave(uint32_t peerId);
+    // queues a message from one of the players for the next tick
+    void Deliver(const Message& msg);
+
+    bool IsTickDue() const;
+    uint32_t GetTimeUntilNextTick() const;
+
+    // claims the due tick, call before handing Tick() to a worker. Returns
+    // how many ticks were dropped because the room fell behind
+    uint32_t BeginTick();
+    // applies everything delivered since the last tick, then builds and
+    // sends the snapshot of every player
+    void Tick(ENetServer& server);
+    bool IsTicking() const;
+
+private:
+    void Flush(ENetServer& server);
+    void Simulate(const std::vector<Message>& messages);
+    void BuildSnapshots(const ENetServer& server);
+    void Spawn(uint32_t peerId, uint32_t inputSequence);
+    void ApplyInput(uint32_t peerId, const Protocol::Input& input);
+
+    uint32_t m_id;
+    size_t m_playerCount;
+
+    std::unique_ptr<Level> m_level;
+    Protocol::CoordinateBits m_bits;
+
+    TickScheduler m_scheduler;
+    // in ticks, see MAX_SNAPSHOT_GAP_MS
+    uint32_t m_maxSendInterval;
+    PositionRelay m_relay;
+
+    std::mutex m_inboxMutex;
+    std::vector<Message> m_inbox;
+    // swapped with the inbox at the start of a tick
+    std::vector<Message> m_received;
+
+    std::map<uint32_t, SendQueue> m_sendQueues;
+
+    std::atomic<bool> m_ticking;
+};
@@ -0,0 +1,180 @@
+#include "RoomManager.h"
+
+#include "ENetServer.h"
+#include "Protocol.h"
+#include "ServerMetrics.h"
+
+#include <algorithm>
+#include <utility>
+#include <iostream>
+
+// longest the network thread blocks, so the main loop still gets to run
+const uint32_t IDLE_POLL_MS = 10;
+
+RoomManager::RoomManager(uint32_t tickRate, int viewRadius, int hysteresis, size_t workerCount, const std::string& levelDirectory,
+    ServerMetrics& metrics)
+    : m_tickRate(tickRate)
+    , m_viewRadius(viewRadius)
+    , m_hysteresis(hysteresis)
+    , m_levelDirectory(levelDirectory)
+    , m_metrics(metrics)
+    , m_pool(workerCount)
+{
+}
+
+void RoomManager::Dispatch(const Message& msg)
+{
+    uint32_t peerId = msg.GetPeerID();
+
+    switch (msg.GetType())
+    {
+
+        case Message::Type::CONNECT:
+            // not in any room until it asks to join one
+            break;
+
+        case Message::Type::DISCONNECT:
+            LeaveRoom(peerId);
+            break;
+
+        case Message::Type::DATA:
+        {
+            Protocol::MessageType type;
+            if (!Protocol::ReadType(msg.GetData(), msg.GetDataLength(), type))
+            {
+                break;
+            }
+
+            if (type == Protocol::MessageType::JOIN)
+            {
+                uint32_t roomId = 0;
+                uint32_t inputSequence = 0;
+                if (Protocol::DecodeJoin(msg.GetData(), msg.GetDataLength(), roomId, inputSequence))
+                {
+                    JoinRoom(msg, roomId);
+                }
+                break;
+            }
+
+            auto iter = m_peerRooms.find(peerId);
+            if (iter != m_peerRooms.end())
+            {
+                iter->second->Deliver(msg);
+            }
+            break;
+        }
+    }
+}
+
+void RoomManager::Update(ENetServer& server)
+{
+    for (auto iter = m_rooms.begin(); iter != m_rooms.end();)
+    {
+        Room* room = iter->second.get();
+        if (room->IsTicking())
+        {
+            ++iter;
+            continue;
+        }
+
+        if (room->GetPlayerCount() == 0)
+        {
+            std::cout << "\nRoom " << room->GetID() << " closed";
+            iter = m_rooms.erase(iter);
+            continue;
+        }
+
+        if (room->IsTickDue())
+        {
+            uint32_t skipped = room->BeginTick();
+            if (skipped > 0)
+            {
+                std::cout << "\nRoom " << room->GetID() << " fell behind, skipped " << skipped << " ticks";
+                m_metrics.RecordSkippedTicks(skipped);
+            }
+            ENetServer* target = &server;
+            ServerMetrics* metrics = &m_metrics;
+            m_pool.Submit([room, target, metrics]() {
+                auto start = ServerMetrics::Clock::now();
+                room->Tick(*target);
+                metrics->RecordTick(ServerMetrics::Clock::now() - start);
+                // the network thread didn't count this room when it went to
+                // sleep, its next tick has to be scheduled from now on
+                target->InterruptPoll();
+            });
+        }
+
+        ++iter;
+    }
+}
+
+uint32_t RoomManager::GetTimeUntilNextTick() const
+{
+    uint32_t timeoutMs = IDLE_POLL_MS;
+    for (const auto& iter : m_rooms)
+    {
+        if (iter.second->IsTicking())
+        {
+            // it interrupts the wait once it's done
+            continue;
+        }
+
+        timeoutMs = std::min(timeoutMs, iter.second->GetTimeUntilNextTick());
+    }
+    return timeoutMs;
+}
+
+size_t RoomManager::GetRoomCount() const
+{
+    return m_rooms.size();
+}
+
+size_t RoomManager::GetWorkerCount() const
+{
+    return m_pool.GetThreadCount();
+}
+
+void RoomManager::JoinRoom(const Message& join, uint32_t roomId)
+{
+    uint32_t peerId = join.GetPeerID();
+
+    // the room places the player when it gets the join itself
+    auto current = m_peerRooms.find(peerId);
+    if (current != m_peerRooms.end() && current->second->GetID() == roomId)
+    {
+        current->second->Deliver(join);
+        return;
+    }
+
+    auto& room = m_rooms[roomId];
+    if (room == nullptr)
+    {
+        std::unique_ptr<Level> level(new Level());
+        if (!level->Load(m_levelDirectory + "/" + Level::GetFileName(roomId), nullptr, nullptr))
+        {
+            std::cout << "\nNo level for room " << roomId << ", client_" << peerId << " stays where it is";
+            m_rooms.erase(roomId);
+            return;
+        }
+
+        room.reset(new Room(roomId, m_tickRate, m_viewRadius, m_hysteresis, std::move(level)));
+        std::cout << "\nRoom " << roomId << " opened";
+    }
+
+    LeaveRoom(peerId);
+    room->Join(peerId);
+    room->Deliver(join);
+    m_peerRooms[peerId] = room.get();
+}
+
+void RoomManager::LeaveRoom(uint32_t peerId)
+{
+    auto iter = m_peerRooms.find(peerId);
+    if (iter == m_peerRooms.end())
+    {
+        return;
+    }
+
+    iter->second->Leave(peerId);
+    m_peerRooms.erase(iter);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Message.h"
+#include "Room.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+class ENetServer;
+class ServerMetrics;
+
+// Owns every room, routes received messages to the room their sender is
+// in and schedules due room ticks on a worker pool. Rooms are created by
+// the first player joining them, with the level of the same number from
+// the level directory, and dropped once the last one leaves.
+// Only the network thread calls into it
+class RoomManager
+{
+
+public:
+    // every tick's duration is recorded in metrics
+    RoomManager(uint32_t tickRate, int viewRadius, int hysteresis, size_t workerCount, const std::string& levelDirectory,
+        ServerMetrics& metrics);
+
+    // JOIN moves the sender between rooms, or respawns it in the one it is
+    // in. Disconnecting removes it from its room, anything else is
+    // delivered to the sender's room
+    void Dispatch(const Message& msg);
+
+    // starts a tick for every due room that isn't still busy with the last
+    // one, the tick sends its snapshots through server when done
+    void Update(ENetServer& server);
+
+    // how long the network thread may block before Update() has work.
+    // Rooms still ticking are left out, their tick interrupts the server's
+    // Poll() when it finishes
+    uint32_t GetTimeUntilNextTick() const;
+
+    size_t GetRoomCount() const;
+    size_t GetWorkerCount() const;
+
+private:
+    void JoinRoom(const Message& join, uint32_t roomId);
+    void LeaveRoom(uint32_t peerId);
+
+    uint32_t m_tickRate;
+    int m_viewRadius;
+    int m_hysteresis;
+    std::string m_levelDirectory;
+
+    ServerMetrics& m_metrics;
+
+    std::map<uint32_t, std::unique_ptr<Room>> m_rooms;
+    std::unordered_map<uint32_t, Room*> m_peerRooms;
+
+    // declared last so its workers finish the ticks still queued or
+    // running and are joined before the rooms go away
+    ThreadPool m_pool;
+};
@@ -0,0 +1,181 @@
+#include "ServerMetrics.h"
+
+#include "RoomManager.h"
+
+#include <algorithm>
+
+const uint32_t ServerMetrics::TICK_BUCKETS_US[TICK_BUCKET_COUNT] = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000
+};
+
+// keys of the "messages" object, in Protocol::MessageType order
+const char* MESSAGE_NAMES[] = { "input", "snapshot", "snapshot_ack", "join" };
+static_assert(sizeof(MESSAGE_NAMES) / sizeof(MESSAGE_NAMES[0]) == static_cast<size_t>(Protocol::MessageType::COUNT),
+    "every message type needs a name");
+
+ServerMetrics::ServerMetrics(uint32_t intervalMs)
+    : m_interval(std::chrono::milliseconds(intervalMs))
+    , m_lastWrite(Clock::now())
+    , m_connects(0)
+    , m_disconnects(0)
+    , m_invalidMessages(0)
+    , m_tickTotalUs(0)
+    , m_tickMaxUs(0)
+    , m_skippedTicks(0)
+{
+    m_messages.fill(0);
+    for (auto& bucket : m_tickBuckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+bool ServerMetrics::Open(const std::string& fileName)
+{
+    m_file.open(fileName, std::ios::out | std::ios::app);
+    m_lastWrite = Clock::now();
+    return m_file.is_open();
+}
+
+bool ServerMetrics::IsOpen() const
+{
+    return m_file.is_open();
+}
+
+void ServerMetrics::RecordMessage(const Message& msg)
+{
+    switch (msg.GetType())
+    {
+
+        case Message::Type::CONNECT:
+            m_connects++;
+            break;
+
+        case Message::Type::DISCONNECT:
+            m_disconnects++;
+            break;
+
+        case Message::Type::DATA:
+        {
+            Protocol::MessageType type;
+            if (Protocol::ReadType(msg.GetData(), msg.GetDataLength(), type))
+            {
+                m_messages[static_cast<size_t>(type)]++;
+            }
+            else
+            {
+                m_invalidMessages++;
+            }
+            break;
+        }
+    }
+}
+
+void ServerMetrics::RecordTick(Clock::duration duration)
+{
+    uint64_t us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+
+    // first bucket whose bound isn't below the duration, or the overflow one
+    size_t bucket = std::lower_bound(TICK_BUCKETS_US, TICK_BUCKETS_US + TICK_BUCKET_COUNT, us) - TICK_BUCKETS_US;
+    m_tickBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_tickTotalUs.fetch_add(us, std::memory_order_relaxed);
+
+    uint64_t max = m_tickMaxUs.load(std::memory_order_relaxed);
+    while (us > max && !m_tickMaxUs.compare_exchange_weak(max, us, std::memory_order_relaxed))
+    {
+    }
+}
+
+void ServerMetrics::RecordSkippedTicks(uint32_t skipped)
+{
+    m_skippedTicks += skipped;
+}
+
+void ServerMetrics::Update(const ENetServer& server, const RoomManager& rooms)
+{
+    if (!m_file.is_open())
+    {
+        return;
+    }
+
+    auto now = Clock::now();
+    if (now - m_lastWrite < m_interval)
+    {
+        return;
+    }
+
+    Write(server, rooms, now);
+    m_lastWrite = now;
+}
+
+void ServerMetrics::Write(const ENetServer& server, const RoomManager& rooms, Clock::time_point now)
+{
+    double seconds = std::chrono::duration<double>(now - m_lastWrite).count();
+
+    ENetServer::Stats stats;
+    server.GetStats(stats);
+
+    auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch())
+        .count();
+
+    m_file << "{\"time_ms\":" << timestamp
+        << ",\"clients\":" << server.NumClients()
+        << ",\"rooms\":" << rooms.GetRoomCount();
+
+    // per second, from the difference to the last line
+    m_file << ",\"net\":{\"packets_in\":" << (stats.packetsReceived - m_lastStats.packetsReceived) / seconds
+        << ",\"packets_out\":" << (stats.packetsSent - m_lastStats.packetsSent) / seconds
+        << ",\"bytes_in\":" << (stats.bytesReceived - m_lastStats.bytesReceived) / seconds
+        << ",\"bytes_out\":" << (stats.bytesSent - m_lastStats.bytesSent) / seconds
+        << ",\"packets_dropped\":" << (stats.packetsDropped - m_lastStats.packetsDropped) / seconds << "}";
+
+    // counts since the last line
+    m_file << ",\"messages\":{\"connect\":" << m_connects << ",\"disconnect\":" << m_disconnects;
+    for (size_t i = 0; i < m_messages.size(); ++i)
+    {
+        m_file << ",\"" << MESSAGE_NAMES[i] << "\":" << m_messages[i];
+    }
+    m_file << ",\"invalid\":" << m_invalidMessages << "}";
+
+    uint64_t tickCount = 0;
+    m_file << ",\"ticks\":{\"buckets_us\":[";
+    for (size_t i = 0; i < TICK_BUCKET_COUNT; ++i)
+    {
+        m_file << (i > 0 ? "," : "") << TICK_BUCKETS_US[i];
+    }
+    m_file << "],\"counts\":[";
+    for (size_t i = 0; i < m_tickBuckets.size(); ++i)
+    {
+        uint64_t count = m_tickBuckets[i].exchange(0, std::memory_order_relaxed);
+        tickCount += count;
+        m_file << (i > 0 ? "," : "") << count;
+    }
+    uint64_t totalUs = m_tickTotalUs.exchange(0, std::memory_order_relaxed);
+    m_file << "],\"count\":" << tickCount
+        << ",\"mean_us\":" << (tickCount > 0 ? totalUs / tickCount : 0)
+        << ",\"max_us\":" << m_tickMaxUs.exchange(0, std::memory_order_relaxed)
+        << ",\"skipped\":" << m_skippedTicks << "}";
+
+    m_file << ",\"peers\":[";
+    for (size_t i = 0; i < stats.peers.size(); ++i)
+    {
+        const auto& peer = stats.peers[i];
+        m_file << (i > 0 ? "," : "") << "{\"id\":" << peer.id
+            << ",\"rtt_ms\":" << peer.roundTripTime
+            << ",\"loss\":" << peer.packetLoss
+            << ",\"throttle\":" << peer.packetThrottle
+            << ",\"in_transit_bytes\":" << peer.reliableDataInTransit
+            << ",\"queued_commands\":" << peer.queuedCommands
+            << ",\"send_interval\":" << peer.sendInterval
+            << ",\"bandwidth\":" << peer.bandwidth << "}";
+    }
+    m_file << "]}" << std::endl;
+
+    m_messages.fill(0);
+    m_connects = 0;
+    m_disconnects = 0;
+    m_invalidMessages = 0;
+    m_skippedTicks = 0;
+    m_lastStats = std::move(stats);
+}
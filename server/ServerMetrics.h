@@ -0,0 +1,65 @@
+#pragma once
+
+#include "ENetServer.h"
+#include "Message.h"
+#include "Protocol.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+class RoomManager;
+
+// Collects what the server spends its capacity on and appends it to a file
+// as one JSON object per line every interval: traffic per second, messages
+// received per type, room tick durations and every peer's connection
+// estimates. Ticks are recorded from the room workers, everything else
+// from the network thread
+class ServerMetrics
+{
+
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // upper bounds of the tick duration buckets in microseconds, longer
+    // ticks land in one more bucket past the last
+    static const size_t TICK_BUCKET_COUNT = 10;
+    static const uint32_t TICK_BUCKETS_US[TICK_BUCKET_COUNT];
+
+    explicit ServerMetrics(uint32_t intervalMs);
+
+    // appends to fileName, nothing is written until this succeeded
+    bool Open(const std::string& fileName);
+    bool IsOpen() const;
+
+    void RecordMessage(const Message& msg);
+    // safe from any thread
+    void RecordTick(Clock::duration duration);
+    void RecordSkippedTicks(uint32_t skipped);
+
+    // writes a line if the interval passed since the last one
+    void Update(const ENetServer& server, const RoomManager& rooms);
+
+private:
+    void Write(const ENetServer& server, const RoomManager& rooms, Clock::time_point now);
+
+    std::ofstream m_file;
+    Clock::duration m_interval;
+    Clock::time_point m_lastWrite;
+    ENetServer::Stats m_lastStats;
+
+    // by Protocol::MessageType, plus connects, disconnects and messages
+    // that didn't decode
+    std::array<uint64_t, static_cast<size_t>(Protocol::MessageType::COUNT)> m_messages;
+    uint64_t m_connects;
+    uint64_t m_disconnects;
+    uint64_t m_invalidMessages;
+
+    std::array<std::atomic<uint64_t>, TICK_BUCKET_COUNT + 1> m_tickBuckets;
+    std::atomic<uint64_t> m_tickTotalUs;
+    std::atomic<uint64_t> m_tickMaxUs;
+    uint64_t m_skippedTicks;
+};
@@ -0,0 +1,81 @@
+#include "TickScheduler.h"
+
+// ticks the loop may run back to back before it gives up catching up
+const uint32_t MAX_CATCH_UP_TICKS = 4;
+
+TickScheduler::TickScheduler(uint32_t tickRate)
+    : m_tickRate(tickRate > 0 ? tickRate : 1)
+    , m_start(Clock::now())
+    , m_tick(0)
+{
+}
+
+void TickScheduler::Start()
+{
+    m_start = Clock::now();
+    m_tick = 0;
+}
+
+uint32_t TickScheduler::Advance()
+{
+    m_tick++;
+
+    auto now = Clock::now();
+    if (now - GetTickTime(m_tick) <= GetTickInterval() * MAX_CATCH_UP_TICKS)
+    {
+        return 0;
+    }
+
+    // too far behind to catch up by running ticks back to back, drop the
+    // missed ticks and carry on from the current one
+    uint64_t behind = static_cast<uint64_t>((now - m_start) / GetTickInterval());
+    uint32_t skipped = static_cast<uint32_t>(behind - m_tick);
+    m_tick = behind;
+    return skipped;
+}
+
+bool TickScheduler::IsTickDue() const
+{
+    return Clock::now() >= GetNextTickTime();
+}
+
+uint32_t TickScheduler::GetTimeUntilNextTick() const
+{
+    auto now = Clock::now();
+    auto next = GetNextTickTime();
+    if (now >= next)
+    {
+        return 0;
+    }
+    // round up so waiting for the result never wakes before the deadline
+    auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(next - now).count();
+    return static_cast<uint32_t>((remaining + 999) / 1000);
+}
+
+uint64_t TickScheduler::GetTick() const
+{
+    return m_tick;
+}
+
+uint32_t TickScheduler::GetTickRate() const
+{
+    return m_tickRate;
+}
+
+TickScheduler::Clock::duration TickScheduler::GetTickInterval() const
+{
+    return std::chrono::duration_cast<Clock::duration>(std::chrono::seconds(1)) / m_tickRate;
+}
+
+TickScheduler::Clock::time_point TickScheduler::GetNextTickTime() const
+{
+    return GetTickTime(m_tick);
+}
+
+TickScheduler::Clock::time_point TickScheduler::GetTickTime(uint64_t tick) const
+{
+    // multiply before dividing so rates that don't divide a second evenly
+    // (e.g. 60 Hz) stay exact
+    auto second = std::chrono::duration_cast<Clock::duration>(std::chrono::seconds(1));
+    return m_start + Clock::duration(static_cast<Clock::rep>(tick * second.count() / m_tickRate));
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// Fixed-rate tick clock for the server loop.
+// NOTE: deadlines are computed from the start time and the tick index instead
+// of "last tick + interval", so a late tick doesn't push every following tick
+// back and the rate doesn't drift over long runs
+class TickScheduler
+{
+
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    explicit TickScheduler(uint32_t tickRate);
+
+    void Start();
+
+    // consumes the due tick, returns how many ticks were dropped because the
+    // loop fell too far behind to catch up
+    uint32_t Advance();
+
+    bool IsTickDue() const;
+    uint32_t GetTimeUntilNextTick() const;
+
+    uint64_t GetTick() const;
+    uint32_t GetTickRate() const;
+    Clock::duration GetTickInterval() const;
+    Clock::time_point GetNextTickTime() const;
+
+private:
+    Clock::time_point GetTickTime(uint64_t tick) const;
+
+    uint32_t m_tickRate;
+    Clock::time_point m_start;
+    // index of the next tick to run
+    uint64_t m_tick;
+};
@@ -1,11 +1,14 @@
 #include "ENetServer.h"
+#include "RoomManager.h"
+#include "ServerMetrics.h"
 
 #include <chrono>
-#include <sstream>
 
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include <conio.h>
 
@@ -13,104 +16,284 @@
 #include <atomic>
 
 const uint32_t PORT = 7000;
+const char* DEFAULT_BIND_ADDRESS = "localhost";
+const uint32_t DEFAULT_MAX_PEERS = 64;
+const uint32_t MAX_SHARDS = 64;
+const uint32_t DEFAULT_TICK_RATE = 60;
+const uint32_t MAX_TICK_RATE = 1000;
+// in tiles, players further away than this aren't sent to each other
+const int DEFAULT_VIEW_RADIUS = 12;
+// extra tiles a player already in view can move away before it's dropped
+const int DEFAULT_VIEW_HYSTERESIS = 3;
+const uint32_t DEFAULT_METRICS_INTERVAL_MS = 1000;
+const char* DEFAULT_LEVEL_DIRECTORY = ".";
+
+const int ESCAPE_KEY = 27;
 
 bool quit = false;
 
 ENetServer* g_server = nullptr;
 
+RoomManager* g_rooms = nullptr;
+
+ServerMetrics* g_metrics = nullptr;
+
 namespace Net {
     enum Types {
         CLIENT_INFO
     };
 }
 
+struct ServerOptions
+{
+    uint32_t port = PORT;
+    std::string bindAddress = DEFAULT_BIND_ADDRESS;
+    uint32_t maxPeers = DEFAULT_MAX_PEERS;
+    uint32_t shards = 1;
+    uint32_t tickRate = DEFAULT_TICK_RATE;
+    // 0 disables interest management, everyone is sent to everyone
+    int viewRadius = DEFAULT_VIEW_RADIUS;
+    int viewHysteresis = DEFAULT_VIEW_HYSTERESIS;
+    // where the level files of the rooms are, the same ones the game plays
+    std::string levelDirectory = DEFAULT_LEVEL_DIRECTORY;
+    // rooms tick on a pool of workers, by default one per core
+    uint32_t workers = std::thread::hardware_concurrency();
+    // empty doesn't export any metrics
+    std::string metricsFile;
+    uint32_t metricsInterval = DEFAULT_METRICS_INTERVAL_MS;
+    // kilobytes per second the server sends at most, over all clients. 0
+    // doesn't limit it
+    uint32_t bandwidth = 0;
+    // clients have to use the same
+    PacketCompression::Type compression = PacketCompression::Type::NONE;
+};
+
+void PrintUsage()
+{
+    std::cout << "Usage: server [--port N] [--bind ADDRESS] [--max-peers N] [--shards N]"
+        << " [--tick-rate HZ] [--view-radius TILES] [--hysteresis TILES] [--workers N]"
+        << " [--levels DIR] [--metrics FILE] [--metrics-interval MS] [--bandwidth KBPS]"
+        << " [--compression none|range|zeropack]" << std::endl;
+}
+
+// every option takes a value, returns false on anything it doesn't know
+bool ParseOptions(int argc, char** argv, ServerOptions& options)
+{
+    for (int i = 1; i < argc; i += 2)
+    {
+        if (i + 1 >= argc)
+        {
+            return false;
+        }
+
+        const char* name = argv[i];
+        const char* value = argv[i + 1];
+        if (strcmp(name, "--port") == 0)
+        {
+            options.port = static_cast<uint32_t>(atoi(value));
+        }
+        else if (strcmp(name, "--bind") == 0)
+        {
+            options.bindAddress = value;
+        }
+        else if (strcmp(name, "--max-peers") == 0)
+        {
+            options.maxPeers = static_cast<uint32_t>(atoi(value));
+        }
+        else if (strcmp(name, "--shards") == 0)
+        {
+            options.shards = static_cast<uint32_t>(atoi(value));
+        }
+        else if (strcmp(name, "--tick-rate") == 0)
+        {
+            options.tickRate = static_cast<uint32_t>(atoi(value));
+        }
+        else if (strcmp(name, "--view-radius") == 0)
+        {
+            options.viewRadius = atoi(value);
+        }
+        else if (strcmp(name, "--hysteresis") == 0)
+        {
+            options.viewHysteresis = atoi(value);
+        }
+        else if (strcmp(name, "--workers") == 0)
+        {
+            options.workers = static_cast<uint32_t>(atoi(value));
+        }
+        else if (strcmp(name, "--levels") == 0)
+        {
+            options.levelDirectory = value;
+        }
+        else if (strcmp(name, "--metrics") == 0)
+        {
+            options.metricsFile = value;
+        }
+        else if (strcmp(name, "--metrics-interval") == 0)
+        {
+            options.metricsInterval = static_cast<uint32_t>(atoi(value));
+        }
+        else if (strcmp(name, "--bandwidth") == 0)
+        {
+            options.bandwidth = static_cast<uint32_t>(atoi(value));
+        }
+        else if (strcmp(name, "--compression") == 0)
+        {
+            if (!PacketCompression::Parse(value, options.compression))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 int main(int argc, char** argv)
 {
-    g_server = new ENetServer();
-    if (g_server->Start(PORT)) 
+    ServerOptions options;
+    if (!ParseOptions(argc, argv, options))
     {
+        PrintUsage();
         return 1;
     }
 
-    auto frameCount = 0;
-
-    int anim = 0;
-
-    auto getInput = []()->int {
-        return _getch();
-    };
-
-    auto future = std::async(std::launch::async, getInput);
-
-    while (true)
+    if (options.tickRate == 0 || options.tickRate > MAX_TICK_RATE)
     {
-        std::system("cls");
+        std::cout << "Invalid tick rate " << options.tickRate << ", expected 1-" << MAX_TICK_RATE << std::endl;
+        return 1;
+    }
 
-        std::cout << "\nServer running";
+    if (options.viewRadius < 0 || options.viewHysteresis < 0)
+    {
+        std::cout << "Invalid view radius " << options.viewRadius << " or hysteresis " << options.viewHysteresis << std::endl;
+        return 1;
+    }
 
-        for (int i = 0; i <= anim; i++)
-        {
-            std::cout << ".";
-        }
+    if (options.shards == 0 || options.shards > MAX_SHARDS || options.port + options.shards - 1 > 0xFFFF)
+    {
+        std::cout << "Invalid shard count " << options.shards << ", expected 1-" << MAX_SHARDS << " ports from " << options.port << std::endl;
+        return 1;
+    }
 
-        if (future.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
-            auto input = future.get();
+    // each shard is one ENet host, which can't address more peers than this
+    if (options.maxPeers == 0 || options.maxPeers > options.shards * ENetServer::MAX_PEERS_PER_SHARD)
+    {
+        std::cout << "Invalid peer limit " << options.maxPeers << ", " << options.shards << " shards take 1-"
+            << options.shards * ENetServer::MAX_PEERS_PER_SHARD << std::endl;
+        return 1;
+    }
 
-            future = std::async(std::launch::async, getInput);
+    if (options.workers == 0)
+    {
+        options.workers = 1;
+    }
 
-            std::cout << " Input: " << input << std::endl;
+    if (options.metricsInterval == 0)
+    {
+        std::cout << "Invalid metrics interval " << options.metricsInterval << std::endl;
+        return 1;
+    }
 
-            std::stringstream stringStream;
+    g_metrics = new ServerMetrics(options.metricsInterval);
+    if (!options.metricsFile.empty() && !g_metrics->Open(options.metricsFile))
+    {
+        std::cout << "Couldn't open metrics file " << options.metricsFile << std::endl;
+        return 1;
+    }
 
-            stringStream << "0-0,0";
+    g_rooms = new RoomManager(options.tickRate, options.viewRadius, options.viewHysteresis, options.workers,
+        options.levelDirectory, *g_metrics);
 
-            // broadcast to all clients
-            g_server->Broadcast(DeliveryType::RELIABLE, stringStream.str());
-        }
+    g_server = new ENetServer();
+    g_server->SetCompression(options.compression);
+    if (g_server->Start(options.port, options.maxPeers, options.shards, options.bindAddress, options.bandwidth * 1000))
+    {
+        std::cout << "Couldn't listen on " << options.bindAddress << " ports " << options.port << "-" << options.port + options.shards - 1 << std::endl;
+        return 1;
+    }
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    std::cout << "Server running on " << options.bindAddress << " ports " << options.port << "-" << options.port + options.shards - 1
+        << " for up to " << options.maxPeers << " players, " << options.tickRate << " Hz, view radius " << options.viewRadius
+        << ", " << options.workers << " room workers, " << PacketCompression::GetName(options.compression)
+        << " compression, press Esc to quit";
 
-        anim++;
-        anim = anim % 3;
+    auto getInput = []()->int {
+        return _getch();
+    };
 
-        // poll for events
-        auto messages = g_server->Poll();
+    auto future = std::async(std::launch::async, getInput);
 
-        // process events
-        for (const auto& msg : messages) 
+    while (true)
+    {
+        // receive phase: wait for the I/O thread to hand over what arrived,
+        // until the next room tick is due
+        auto messages = g_server->Poll(g_rooms->GetTimeUntilNextTick());
+        for (const auto& msg : messages)
         {
-            uint32_t id = msg.GetPeerID();
-
-            switch (msg.GetType()) 
+            if (msg.GetType() == Message::Type::CONNECT)
             {
+                std::cout << "\nConnection from client_" << msg.GetPeerID() << " received";
+            }
+            else if (msg.GetType() == Message::Type::DISCONNECT)
+            {
+                std::cout << "\nConnection from client_" << msg.GetPeerID() << " lost";
+            }
+            g_metrics->RecordMessage(msg);
+            g_rooms->Dispatch(msg);
+        }
 
-                case Message::Type::CONNECT:
-                        std::cout << "\nConnection from client_" << id << " received";
-                        break;
-
-                case Message::Type::DISCONNECT:
+        // rooms simulate and send their snapshots on the workers, the
+        // server's I/O thread puts them on the wire
+        g_rooms->Update(*g_server);
+        g_server->Flush();
 
-                        std::cout << "\nConnection from client_" << id << " lost";
-                        break;
+        g_metrics->Update(*g_server, *g_rooms);
 
-                case Message::Type::DATA:  
-                    
-                        std::cout << "\nData from client_" << id << " " << msg.GetData();
+        if (future.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            auto input = future.get();
 
-                        break;
+            if (input == ESCAPE_KEY)
+            {
+                quit = true;
             }
-        }        
+            else
+            {
+                // a future left reading a key would hold up the exit until
+                // another one is pressed
+                future = std::async(std::launch::async, getInput);
+            }
+        }
 
         // check if exit
-        if (quit) 
+        if (quit)
         {
             break;
         }
     }
 
+    // let running ticks finish before disconnecting everyone
+    delete g_rooms;
+    g_rooms = nullptr;
+
     // stop server and disconnect all clients
-    g_server->Stop();
+    std::cout << "\nDisconnecting " << g_server->NumClients() << " clients" << std::endl;
+    std::vector<uint32_t> timedOut;
+    if (g_server->Stop(&timedOut))
+    {
+        std::cout << timedOut.size() << " clients didn't acknowledge the disconnect:";
+        for (uint32_t id : timedOut)
+        {
+            std::cout << " client_" << id;
+        }
+        std::cout << std::endl;
+    }
 
     delete g_server;
     g_server = nullptr;
+
+    delete g_metrics;
+    g_metrics = nullptr;
 }
@@ -0,0 +1,127 @@
+#include "BitStream.h"
+
+BitWriter::BitWriter(uint8_t* buffer, size_t capacity)
+    : m_buffer(buffer)
+    , m_capacity(capacity)
+    , m_bitPos(0)
+    , m_overflowed(false)
+{
+}
+
+void BitWriter::Write(uint32_t value, uint32_t bits)
+{
+    if (m_overflowed || m_bitPos + bits > m_capacity * 8)
+    {
+        m_overflowed = true;
+        return;
+    }
+
+    while (bits > 0)
+    {
+        size_t byteIndex = m_bitPos / 8;
+        uint32_t bitOffset = static_cast<uint32_t>(m_bitPos % 8);
+        if (bitOffset == 0)
+        {
+            // starting a fresh byte, clear whatever the buffer held
+            m_buffer[byteIndex] = 0;
+        }
+
+        uint32_t free = 8 - bitOffset;
+        uint32_t count = bits < free ? bits : free;
+        uint32_t chunk = (value >> (bits - count)) & ((1u << count) - 1);
+
+        m_buffer[byteIndex] |= static_cast<uint8_t>(chunk << (free - count));
+        m_bitPos += count;
+        bits -= count;
+    }
+}
+
+void BitWriter::WriteVarint(uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        Write((value & 0x7F) | 0x80, 8);
+        value >>= 7;
+    }
+    Write(value, 8);
+}
+
+void BitWriter::WriteByte(uint8_t value)
+{
+    Write(value, 8);
+}
+
+size_t BitWriter::GetLength() const
+{
+    return (m_bitPos + 7) / 8;
+}
+
+bool BitWriter::HasOverflowed() const
+{
+    return m_overflowed;
+}
+
+BitReader::BitReader(const uint8_t* data, size_t length)
+    : m_data(data)
+    , m_length(length)
+    , m_bitPos(0)
+    , m_overflowed(false)
+{
+}
+
+uint32_t BitReader::Read(uint32_t bits)
+{
+    if (m_overflowed || m_bitPos + bits > m_length * 8)
+    {
+        m_overflowed = true;
+        return 0;
+    }
+
+    uint32_t value = 0;
+    while (bits > 0)
+    {
+        uint8_t byte = m_data[m_bitPos / 8];
+        uint32_t bitOffset = static_cast<uint32_t>(m_bitPos % 8);
+
+        uint32_t available = 8 - bitOffset;
+        uint32_t count = bits < available ? bits : available;
+        uint32_t chunk = (byte >> (available - count)) & ((1u << count) - 1);
+
+        value = (value << count) | chunk;
+        m_bitPos += count;
+        bits -= count;
+    }
+    return value;
+}
+
+uint32_t BitReader::ReadVarint()
+{
+    uint32_t value = 0;
+    for (uint32_t shift = 0; shift < 35; shift += 7)
+    {
+        uint32_t byte = Read(8);
+        value |= (byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return value;
+        }
+    }
+    // more than 5 bytes can't be a 32 bit value
+    m_overflowed = true;
+    return 0;
+}
+
+uint8_t BitReader::ReadByte()
+{
+    return static_cast<uint8_t>(Read(8));
+}
+
+size_t BitReader::GetBitsLeft() const
+{
+    return m_length * 8 - m_bitPos;
+}
+
+bool BitReader::HasOverflowed() const
+{
+    return m_overflowed;
+}
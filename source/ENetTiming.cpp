@@ -0,0 +1,38 @@
+#include "ENetTiming.h"
+
+#include <enet/time.h>
+
+#include <algorithm>
+
+uint32_t ENetTiming::GetServiceTimeout(const ENetHost* host, uint32_t maxTimeout)
+{
+    // the same checks enet_host_service() makes: reliable commands not
+    // acknowledged in time are resent, and a connected peer that went quiet
+    // with nothing in flight is pinged
+    uint32_t timeout = maxTimeout;
+    enet_uint32 now = enet_time_get();
+    for (size_t i = 0; i < host->peerCount; ++i)
+    {
+        const ENetPeer* peer = &host->peers[i];
+        enet_uint32 due;
+        if (!enet_list_empty(&peer->sentReliableCommands))
+        {
+            due = peer->nextTimeout;
+        }
+        else if (peer->state == ENET_PEER_STATE_CONNECTED || peer->state == ENET_PEER_STATE_DISCONNECT_LATER)
+        {
+            due = peer->lastReceiveTime + peer->pingInterval;
+        }
+        else
+        {
+            continue;
+        }
+
+        if (ENET_TIME_LESS_EQUAL(due, now))
+        {
+            return 0;
+        }
+        timeout = std::min(timeout, ENET_TIME_DIFFERENCE(due, now));
+    }
+    return timeout;
+}
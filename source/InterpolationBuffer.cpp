@@ -0,0 +1,242 @@
+#include "InterpolationBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+
+// until two snapshots tell how far apart they come
+const double DEFAULT_INTERVAL_MS = 50.0;
+// delay is one snapshot interval plus this many times the jitter
+const double JITTER_FACTOR = 3.0;
+const double MAX_DELAY_MS = 250.0;
+// how fast the lowest transit time is allowed to creep up, in ms per ms
+// of server time
+const double BASE_TRANSIT_DRIFT = 0.001;
+// gaps between snapshots longer than this are quiet rooms, not jitter
+const double MAX_INTERVAL_MS = 250.0;
+// past the newest sample a player keeps moving for at most this long
+const double MAX_EXTRAPOLATION_MS = 100.0;
+// how far back the last step is looked for, a player that took none in
+// this long is standing still
+const double VELOCITY_WINDOW_MS = 250.0;
+// samples kept per player behind the playback time, and in total
+const double HISTORY_MS = VELOCITY_WINDOW_MS;
+const size_t MAX_SAMPLES = 256;
+
+InterpolationBuffer::InterpolationBuffer()
+{
+    Reset();
+}
+
+void InterpolationBuffer::Reset()
+{
+    m_epoch = Clock::now();
+    m_players.clear();
+    m_hasTransit = false;
+    m_baseTransit = 0.0;
+    m_lastTransit = 0.0;
+    m_jitter = 0.0;
+    m_interval = DEFAULT_INTERVAL_MS;
+    m_lastServerTime = 0;
+}
+
+void InterpolationBuffer::Add(const Protocol::Snapshot& snapshot, Clock::time_point arrival)
+{
+    double localTime = std::chrono::duration<double, std::milli>(arrival - m_epoch).count();
+    double transit = localTime - snapshot.serverTime;
+
+    if (!m_hasTransit)
+    {
+        m_hasTransit = true;
+        m_baseTransit = transit;
+        m_lastTransit = transit;
+    }
+    else
+    {
+        m_jitter += (std::abs(transit - m_lastTransit) - m_jitter) / 16.0;
+        m_lastTransit = transit;
+
+        if (snapshot.serverTime > m_lastServerTime)
+        {
+            double interval = std::min(static_cast<double>(snapshot.serverTime - m_lastServerTime), MAX_INTERVAL_MS);
+            m_interval += (interval - m_interval) / 8.0;
+            m_baseTransit += (snapshot.serverTime - m_lastServerTime) * BASE_TRANSIT_DRIFT;
+        }
+        m_baseTransit = std::min(m_baseTransit, transit);
+    }
+    m_lastServerTime = std::max(m_lastServerTime, snapshot.serverTime);
+
+    // players sorted by id on both sides, whoever isn't in the snapshot
+    // left the view at its time
+    m_gone.clear();
+    auto player = snapshot.players.begin();
+    for (const auto& iter : m_players)
+    {
+        while (player != snapshot.players.end() && player->peerId < iter.first)
+        {
+            ++player;
+        }
+        if (player == snapshot.players.end() || player->peerId != iter.first)
+        {
+            m_gone.push_back(iter.first);
+        }
+    }
+
+    for (const auto& position : snapshot.players)
+    {
+        TimedPosition sample = { snapshot.serverTime, true, position.x, position.y };
+        Insert(position.peerId, sample);
+    }
+    for (uint32_t peerId : m_gone)
+    {
+        TimedPosition sample = { snapshot.serverTime, false, 0, 0 };
+        Insert(peerId, sample);
+    }
+}
+
+void InterpolationBuffer::Sample(Clock::time_point now, const IsBlocked& isBlocked, std::vector<Protocol::PlayerPosition>& players)
+{
+    players.clear();
+    if (!m_hasTransit)
+    {
+        return;
+    }
+
+    // the server time shown now
+    double localTime = std::chrono::duration<double, std::milli>(now - m_epoch).count();
+    double time = localTime - m_baseTransit - GetDelay();
+
+    for (auto iter = m_players.begin(); iter != m_players.end();)
+    {
+        auto& samples = iter->second;
+
+        // what is older than the history isn't needed anymore, as long as
+        // one sample at or before the playback time stays
+        while (samples.size() > 1 && samples[1].serverTime + HISTORY_MS <= time)
+        {
+            samples.pop_front();
+        }
+        if (samples.size() == 1 && !samples.front().present && samples.front().serverTime <= time)
+        {
+            iter = m_players.erase(iter);
+            continue;
+        }
+
+        Protocol::PlayerPosition player;
+        player.peerId = iter->first;
+        if (SamplePlayer(samples, time, isBlocked, player))
+        {
+            players.push_back(player);
+        }
+        ++iter;
+    }
+}
+
+uint32_t InterpolationBuffer::GetDelay() const
+{
+    return static_cast<uint32_t>(std::min(m_interval + JITTER_FACTOR * m_jitter, MAX_DELAY_MS));
+}
+
+uint32_t InterpolationBuffer::GetJitter() const
+{
+    return static_cast<uint32_t>(m_jitter);
+}
+
+int InterpolationBuffer::Lerp(int a, int b, uint32_t from, uint32_t to, double time)
+{
+    if (to <= from)
+    {
+        return b;
+    }
+    double t = std::min(std::max((time - from) / (to - from), 0.0), 1.0);
+    return a + static_cast<int>(std::lround((b - a) * t));
+}
+
+void InterpolationBuffer::Insert(uint32_t peerId, const TimedPosition& sample)
+{
+    auto& samples = m_players[peerId];
+
+    // snapshots nearly always arrive in order
+    auto position = samples.end();
+    while (position != samples.begin() && (position - 1)->serverTime >= sample.serverTime)
+    {
+        --position;
+    }
+    if (position != samples.end() && position->serverTime == sample.serverTime)
+    {
+        return;
+    }
+    samples.insert(position, sample);
+
+    if (samples.size() > MAX_SAMPLES)
+    {
+        samples.pop_front();
+    }
+}
+
+bool InterpolationBuffer::SamplePlayer(const std::deque<TimedPosition>& samples, double time, const IsBlocked& isBlocked,
+    Protocol::PlayerPosition& player) const
+{
+    // the last sample at or before the playback time, and the one after
+    size_t next = 0;
+    while (next < samples.size() && samples[next].serverTime <= time)
+    {
+        next++;
+    }
+    if (next == 0)
+    {
+        // not there yet
+        return false;
+    }
+
+    const TimedPosition& previous = samples[next - 1];
+    if (!previous.present)
+    {
+        return false;
+    }
+
+    if (next < samples.size())
+    {
+        const TimedPosition& following = samples[next];
+        if (!following.present)
+        {
+            player.x = previous.x;
+            player.y = previous.y;
+            return true;
+        }
+
+        player.x = Lerp(previous.x, following.x, previous.serverTime, following.serverTime, time);
+        player.y = Lerp(previous.y, following.y, previous.serverTime, following.serverTime, time);
+        return true;
+    }
+
+    // nothing newer arrived yet: keep going at the pace of the last step,
+    // at most one tile and not into anything
+    player.x = previous.x;
+    player.y = previous.y;
+    for (size_t i = next - 1; i-- > 0;)
+    {
+        const TimedPosition& earlier = samples[i];
+        if (!earlier.present || earlier.serverTime + VELOCITY_WINDOW_MS < previous.serverTime)
+        {
+            break;
+        }
+        if (earlier.x == previous.x && earlier.y == previous.y)
+        {
+            continue;
+        }
+
+        double ahead = std::min(time - previous.serverTime, MAX_EXTRAPOLATION_MS);
+        double stepTime = previous.serverTime - earlier.serverTime;
+        int x = Lerp(previous.x, previous.x + (previous.x - earlier.x), 0, static_cast<uint32_t>(stepTime), ahead);
+        int y = Lerp(previous.y, previous.y + (previous.y - earlier.y), 0, static_cast<uint32_t>(stepTime), ahead);
+        x = std::min(std::max(x, previous.x - 1), previous.x + 1);
+        y = std::min(std::max(y, previous.y - 1), previous.y + 1);
+        if (!isBlocked(x, y))
+        {
+            player.x = x;
+            player.y = y;
+        }
+        break;
+    }
+    return true;
+}
@@ -1,9 +1,19 @@
 #include "Message.h"
 
-Message::Message(uint32_t peerId, Type type, const std::string& data)
+Message::Message(uint32_t peerId, Type type)
     : m_peerID(peerId)
     , m_type(type)
+    , m_data(nullptr)
+    , m_length(0)
+{
+}
+
+Message::Message(uint32_t peerId, const std::shared_ptr<ENetPacket>& packet, const uint8_t* data, size_t length)
+    : m_peerID(peerId)
+    , m_type(DATA)
+    , m_packet(packet)
     , m_data(data)
+    , m_length(length)
 {
 }
 
@@ -18,7 +28,12 @@ Message::Type Message::GetType() const
     return m_type;
 }
 
-const std::string& Message::GetData() const
+const uint8_t* Message::GetData() const
 {
     return m_data;
 }
+
+size_t Message::GetDataLength() const
+{
+    return m_length;
+}
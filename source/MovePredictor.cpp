@@ -0,0 +1,66 @@
+#include "MovePredictor.h"
+
+#include <algorithm>
+
+MovePredictor::MovePredictor()
+    : m_nextSequence(Protocol::NO_INPUT + 1)
+    , m_restartSequence(Protocol::NO_INPUT)
+{
+}
+
+uint32_t MovePredictor::Restart()
+{
+    // the sequence keeps counting, so snapshots still in flight from before
+    // can't be taken for acknowledgements of what comes after
+    m_pending.clear();
+    m_restartSequence = m_nextSequence++;
+    return m_restartSequence;
+}
+
+void MovePredictor::Push(Protocol::Direction direction)
+{
+    Protocol::Input input;
+    input.sequence = m_nextSequence++;
+    input.direction = direction;
+    m_pending.push_back(input);
+}
+
+size_t MovePredictor::GetPending(Protocol::Input* inputs, size_t maxCount) const
+{
+    size_t count = m_pending.size() < maxCount ? m_pending.size() : maxCount;
+    std::copy(m_pending.begin(), m_pending.begin() + count, inputs);
+    return count;
+}
+
+bool MovePredictor::Reconcile(const Protocol::Snapshot& snapshot, const IsBlocked& isBlocked, int& x, int& y)
+{
+    if (!snapshot.hasSelf || snapshot.inputSequence < m_restartSequence)
+    {
+        return false;
+    }
+
+    while (!m_pending.empty() && m_pending.front().sequence <= snapshot.inputSequence)
+    {
+        m_pending.pop_front();
+    }
+
+    x = snapshot.selfX;
+    y = snapshot.selfY;
+    for (const auto& input : m_pending)
+    {
+        int nextX = x;
+        int nextY = y;
+        Protocol::Step(input.direction, nextX, nextY);
+        if (!isBlocked(nextX, nextY))
+        {
+            x = nextX;
+            y = nextY;
+        }
+    }
+    return true;
+}
+
+size_t MovePredictor::GetPendingCount() const
+{
+    return m_pending.size();
+}
@@ -0,0 +1,200 @@
+#include "PacketCompression.h"
+
+#include <cstring>
+
+// bytes behind each tag byte, one bit of the tag each
+const size_t ZERO_PACK_GROUP_SIZE = 8;
+
+namespace PacketCompression
+{
+    // ENet wants a context, ZERO_PACK keeps no state in it
+    static int s_zeroPackContext = 0;
+
+    bool Parse(const char* name, Type& type)
+    {
+        if (strcmp(name, "none") == 0)
+        {
+            type = Type::NONE;
+        }
+        else if (strcmp(name, "range") == 0)
+        {
+            type = Type::RANGE_CODER;
+        }
+        else if (strcmp(name, "zeropack") == 0)
+        {
+            type = Type::ZERO_PACK;
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    }
+
+    const char* GetName(Type type)
+    {
+        switch (type)
+        {
+            case Type::RANGE_CODER:
+                return "range";
+            case Type::ZERO_PACK:
+                return "zeropack";
+            default:
+                return "none";
+        }
+    }
+
+    bool Enable(ENetHost* host, Type type)
+    {
+        if (host == nullptr)
+        {
+            return false;
+        }
+
+        if (type == Type::RANGE_CODER)
+        {
+            return enet_host_compress_with_range_coder(host) == 0;
+        }
+
+        if (type == Type::ZERO_PACK)
+        {
+            ENetCompressor compressor;
+            compressor.context = &s_zeroPackContext;
+            compressor.compress = ZeroPack;
+            compressor.decompress = ZeroUnpack;
+            compressor.destroy = nullptr;
+            enet_host_compress(host, &compressor);
+            return true;
+        }
+
+        enet_host_compress(host, nullptr);
+        return true;
+    }
+
+    // the datagram's length goes first as a varint, the last group can't
+    // tell it apart from trailing zeros
+    size_t ENET_CALLBACK ZeroPack(void*, const ENetBuffer* inBuffers, size_t inBufferCount, size_t inLimit,
+        uint8_t* outData, size_t outLimit)
+    {
+        size_t out = 0;
+        size_t value = inLimit;
+        do
+        {
+            if (out >= outLimit)
+            {
+                return 0;
+            }
+            outData[out++] = static_cast<uint8_t>((value & 0x7F) | (value > 0x7F ? 0x80 : 0));
+            value >>= 7;
+        } while (value > 0);
+
+        // a group can span buffers, ENet hands over its command headers
+        // and the packets' data separately
+        // 0 until the first group starts, the length is always in front
+        size_t tag = 0;
+        uint8_t mask = 0;
+        size_t position = ZERO_PACK_GROUP_SIZE;
+        size_t remaining = inLimit;
+        for (size_t i = 0; i < inBufferCount && remaining > 0; ++i)
+        {
+            const uint8_t* data = static_cast<const uint8_t*>(inBuffers[i].data);
+            size_t length = inBuffers[i].dataLength < remaining ? inBuffers[i].dataLength : remaining;
+            remaining -= length;
+
+            for (size_t j = 0; j < length; ++j)
+            {
+                if (position == ZERO_PACK_GROUP_SIZE)
+                {
+                    if (out >= outLimit)
+                    {
+                        return 0;
+                    }
+                    if (tag > 0)
+                    {
+                        outData[tag] = mask;
+                    }
+                    tag = out++;
+                    mask = 0;
+                    position = 0;
+                }
+
+                if (data[j] != 0)
+                {
+                    if (out >= outLimit)
+                    {
+                        return 0;
+                    }
+                    outData[out++] = data[j];
+                    mask |= static_cast<uint8_t>(1 << position);
+                }
+                position++;
+            }
+        }
+        if (remaining > 0)
+        {
+            return 0;
+        }
+        if (tag > 0)
+        {
+            outData[tag] = mask;
+        }
+        return out;
+    }
+
+    size_t ENET_CALLBACK ZeroUnpack(void*, const uint8_t* inData, size_t inLimit, uint8_t* outData, size_t outLimit)
+    {
+        size_t in = 0;
+        size_t length = 0;
+        for (int shift = 0; ; shift += 7)
+        {
+            if (in >= inLimit || shift > 28)
+            {
+                return 0;
+            }
+            uint8_t byte = inData[in++];
+            length |= static_cast<size_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                break;
+            }
+        }
+        if (length > outLimit)
+        {
+            return 0;
+        }
+
+        size_t out = 0;
+        while (out < length)
+        {
+            if (in >= inLimit)
+            {
+                return 0;
+            }
+            uint8_t mask = inData[in++];
+            size_t groupSize = length - out < ZERO_PACK_GROUP_SIZE ? length - out : ZERO_PACK_GROUP_SIZE;
+            // bits past the end of the datagram are never set
+            if ((mask >> groupSize) != 0)
+            {
+                return 0;
+            }
+
+            for (size_t i = 0; i < groupSize; ++i)
+            {
+                if ((mask & (1 << i)) == 0)
+                {
+                    outData[out++] = 0;
+                }
+                else if (in < inLimit)
+                {
+                    outData[out++] = inData[in++];
+                }
+                else
+                {
+                    return 0;
+                }
+            }
+        }
+        // anything left over means the datagram wasn't packed by us
+        return in == inLimit ? out : 0;
+    }
+}
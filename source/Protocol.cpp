@@ -0,0 +1,460 @@
+#include "Protocol.h"
+
+#include "BitStream.h"
+
+namespace Protocol
+{
+    const uint32_t COORDINATE_BITS_WIDTH = 4;
+    const uint32_t DIRECTION_BITS = 2;
+    // input counts are written minus one
+    const uint32_t INPUT_COUNT_BITS = 5;
+    static_assert(MAX_INPUTS_PER_MESSAGE == 1 << INPUT_COUNT_BITS, "input count has to fit its bits");
+    const size_t HEADER_SIZE = 2;
+    const size_t MAX_VARINT_SIZE = 5;
+    // two coordinates of at most 15 bits
+    const size_t MAX_COORDINATES_SIZE = 4;
+
+    static uint8_t BitsFor(int size)
+    {
+        uint8_t bits = 1;
+        while (bits < 15 && (1 << bits) < size)
+        {
+            bits++;
+        }
+        return bits;
+    }
+
+    static bool InRange(int x, int y, CoordinateBits bits)
+    {
+        return x >= 0 && x < (1 << bits.x) && y >= 0 && y < (1 << bits.y);
+    }
+
+    static void WriteHeader(BitWriter& writer, MessageType type)
+    {
+        writer.WriteByte(VERSION);
+        writer.WriteByte(static_cast<uint8_t>(type));
+    }
+
+    static void WriteCoordinateBits(BitWriter& writer, CoordinateBits bits)
+    {
+        writer.Write(bits.x, COORDINATE_BITS_WIDTH);
+        writer.Write(bits.y, COORDINATE_BITS_WIDTH);
+    }
+
+    static CoordinateBits ReadCoordinateBits(BitReader& reader)
+    {
+        CoordinateBits bits;
+        bits.x = static_cast<uint8_t>(reader.Read(COORDINATE_BITS_WIDTH));
+        bits.y = static_cast<uint8_t>(reader.Read(COORDINATE_BITS_WIDTH));
+        return bits;
+    }
+
+    // players are sorted by id, so ids are written as the gap to the
+    // previous one which nearly always fits a single byte
+    static void WritePlayer(BitWriter& writer, const PlayerPosition& player, uint32_t& previousId, CoordinateBits bits)
+    {
+        writer.WriteVarint(player.peerId - previousId);
+        writer.Write(static_cast<uint32_t>(player.x), bits.x);
+        writer.Write(static_cast<uint32_t>(player.y), bits.y);
+        previousId = player.peerId;
+    }
+
+    static PlayerPosition ReadPlayer(BitReader& reader, uint32_t& previousId, CoordinateBits bits)
+    {
+        PlayerPosition player;
+        player.peerId = previousId + reader.ReadVarint();
+        player.x = static_cast<int>(reader.Read(bits.x));
+        player.y = static_cast<int>(reader.Read(bits.y));
+        previousId = player.peerId;
+        return player;
+    }
+
+    // walks both sorted player lists at once, reporting players that joined
+    // or moved since the baseline and the ids of those that left
+    template <typename OnChanged, typename OnRemoved>
+    static void Diff(const Snapshot& snapshot, const Snapshot& baseline, OnChanged onChanged, OnRemoved onRemoved)
+    {
+        size_t current = 0;
+        size_t base = 0;
+        while (current < snapshot.players.size() || base < baseline.players.size())
+        {
+            const PlayerPosition* player = current < snapshot.players.size() ? &snapshot.players[current] : nullptr;
+            const PlayerPosition* old = base < baseline.players.size() ? &baseline.players[base] : nullptr;
+
+            if (old == nullptr || (player != nullptr && player->peerId < old->peerId))
+            {
+                onChanged(*player);
+                current++;
+            }
+            else if (player == nullptr || old->peerId < player->peerId)
+            {
+                onRemoved(old->peerId);
+                base++;
+            }
+            else
+            {
+                if (player->x != old->x || player->y != old->y)
+                {
+                    onChanged(*player);
+                }
+                current++;
+                base++;
+            }
+        }
+    }
+
+    static bool ReadHeader(BitReader& reader, MessageType expected)
+    {
+        return reader.ReadByte() == VERSION && reader.ReadByte() == static_cast<uint8_t>(expected);
+    }
+
+    void Step(Direction direction, int& x, int& y)
+    {
+        switch (direction)
+        {
+            case Direction::LEFT:
+                x--;
+                break;
+            case Direction::RIGHT:
+                x++;
+                break;
+            case Direction::UP:
+                y--;
+                break;
+            case Direction::DOWN:
+                y++;
+                break;
+        }
+    }
+
+    CoordinateBits CoordinateBits::ForLevel(int width, int height)
+    {
+        CoordinateBits bits;
+        bits.x = BitsFor(width);
+        bits.y = BitsFor(height);
+        return bits;
+    }
+
+    size_t GetMaxInputSize()
+    {
+        return HEADER_SIZE + MAX_VARINT_SIZE + (INPUT_COUNT_BITS + MAX_INPUTS_PER_MESSAGE * DIRECTION_BITS + 7) / 8;
+    }
+
+    size_t GetMaxSnapshotSize(size_t playerCount, size_t baselinePlayerCount)
+    {
+        // header, room, sequences, time, coordinate widths and counts, the
+        // recipient's own state, then every player at worst moved and every
+        // baseline player at worst removed
+        return HEADER_SIZE + 6 * MAX_VARINT_SIZE + 1
+            + 1 + MAX_VARINT_SIZE + MAX_COORDINATES_SIZE
+            + playerCount * (MAX_VARINT_SIZE + MAX_COORDINATES_SIZE)
+            + baselinePlayerCount * MAX_VARINT_SIZE;
+    }
+
+    size_t GetMaxSnapshotAckSize()
+    {
+        return HEADER_SIZE + MAX_VARINT_SIZE;
+    }
+
+    size_t GetMaxJoinSize()
+    {
+        return HEADER_SIZE + 2 * MAX_VARINT_SIZE;
+    }
+
+    size_t EncodeInputs(const Input* inputs, size_t count, uint8_t* buffer, size_t capacity)
+    {
+        if (count == 0 || count > MAX_INPUTS_PER_MESSAGE)
+        {
+            return 0;
+        }
+
+        // only the first sequence is written, the rest follow from it
+        BitWriter writer(buffer, capacity);
+        WriteHeader(writer, MessageType::INPUT);
+        writer.WriteVarint(inputs[0].sequence);
+        writer.Write(static_cast<uint32_t>(count - 1), INPUT_COUNT_BITS);
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (inputs[i].sequence != inputs[0].sequence + i)
+            {
+                return 0;
+            }
+            writer.Write(static_cast<uint32_t>(inputs[i].direction), DIRECTION_BITS);
+        }
+
+        return writer.HasOverflowed() ? 0 : writer.GetLength();
+    }
+
+    size_t EncodeSnapshot(const Snapshot& snapshot, const Snapshot* baseline, CoordinateBits bits, uint8_t* buffer, size_t capacity)
+    {
+        BitWriter writer(buffer, capacity);
+        WriteHeader(writer, MessageType::SNAPSHOT);
+        writer.WriteVarint(snapshot.roomId);
+        writer.WriteVarint(snapshot.sequence);
+        writer.WriteVarint(baseline != nullptr ? baseline->sequence : NO_BASELINE);
+        writer.WriteVarint(snapshot.serverTime);
+        WriteCoordinateBits(writer, bits);
+
+        for (const auto& player : snapshot.players)
+        {
+            if (!InRange(player.x, player.y, bits))
+            {
+                return 0;
+            }
+        }
+
+        // the recipient's own state goes in every snapshot, it is what
+        // acknowledges its inputs
+        writer.Write(snapshot.hasSelf ? 1 : 0, 1);
+        if (snapshot.hasSelf)
+        {
+            if (!InRange(snapshot.selfX, snapshot.selfY, bits))
+            {
+                return 0;
+            }
+            writer.WriteVarint(snapshot.inputSequence);
+            writer.Write(static_cast<uint32_t>(snapshot.selfX), bits.x);
+            writer.Write(static_cast<uint32_t>(snapshot.selfY), bits.y);
+        }
+
+        if (baseline == nullptr)
+        {
+            uint32_t previousId = 0;
+            writer.WriteVarint(static_cast<uint32_t>(snapshot.players.size()));
+            for (const auto& player : snapshot.players)
+            {
+                WritePlayer(writer, player, previousId, bits);
+            }
+            return writer.HasOverflowed() ? 0 : writer.GetLength();
+        }
+
+        // counts go first, so the diff is walked once to count and once per
+        // list to write, which avoids collecting it anywhere
+        uint32_t changedCount = 0;
+        uint32_t removedCount = 0;
+        Diff(snapshot, *baseline,
+            [&](const PlayerPosition&) { changedCount++; },
+            [&](uint32_t) { removedCount++; });
+
+        uint32_t previousId = 0;
+        writer.WriteVarint(changedCount);
+        Diff(snapshot, *baseline,
+            [&](const PlayerPosition& player) { WritePlayer(writer, player, previousId, bits); },
+            [](uint32_t) {});
+
+        previousId = 0;
+        writer.WriteVarint(removedCount);
+        Diff(snapshot, *baseline,
+            [](const PlayerPosition&) {},
+            [&](uint32_t peerId) {
+                writer.WriteVarint(peerId - previousId);
+                previousId = peerId;
+            });
+
+        return writer.HasOverflowed() ? 0 : writer.GetLength();
+    }
+
+    size_t EncodeSnapshotAck(uint32_t sequence, uint8_t* buffer, size_t capacity)
+    {
+        BitWriter writer(buffer, capacity);
+        WriteHeader(writer, MessageType::SNAPSHOT_ACK);
+        writer.WriteVarint(sequence);
+
+        return writer.HasOverflowed() ? 0 : writer.GetLength();
+    }
+
+    size_t EncodeJoin(uint32_t roomId, uint32_t inputSequence, uint8_t* buffer, size_t capacity)
+    {
+        BitWriter writer(buffer, capacity);
+        WriteHeader(writer, MessageType::JOIN);
+        writer.WriteVarint(roomId);
+        writer.WriteVarint(inputSequence);
+
+        return writer.HasOverflowed() ? 0 : writer.GetLength();
+    }
+
+    bool ReadType(const uint8_t* data, size_t length, MessageType& type)
+    {
+        if (length < HEADER_SIZE || data[0] != VERSION || data[1] >= static_cast<uint8_t>(MessageType::COUNT))
+        {
+            return false;
+        }
+        type = static_cast<MessageType>(data[1]);
+        return true;
+    }
+
+    bool DecodeInputs(const uint8_t* data, size_t length, Input* inputs, size_t& count)
+    {
+        BitReader reader(data, length);
+        if (!ReadHeader(reader, MessageType::INPUT))
+        {
+            return false;
+        }
+
+        uint32_t sequence = reader.ReadVarint();
+        count = reader.Read(INPUT_COUNT_BITS) + 1;
+        for (size_t i = 0; i < count; ++i)
+        {
+            inputs[i].sequence = sequence + static_cast<uint32_t>(i);
+            inputs[i].direction = static_cast<Direction>(reader.Read(DIRECTION_BITS));
+        }
+
+        return !reader.HasOverflowed();
+    }
+
+    bool ReadSnapshotHeader(const uint8_t* data, size_t length, uint32_t& roomId, uint32_t& sequence, uint32_t& baselineSequence)
+    {
+        BitReader reader(data, length);
+        if (!ReadHeader(reader, MessageType::SNAPSHOT))
+        {
+            return false;
+        }
+
+        roomId = reader.ReadVarint();
+        sequence = reader.ReadVarint();
+        baselineSequence = reader.ReadVarint();
+
+        return !reader.HasOverflowed();
+    }
+
+    bool DecodeSnapshot(const uint8_t* data, size_t length, const Snapshot* baseline, Snapshot& snapshot)
+    {
+        snapshot.players.clear();
+
+        BitReader reader(data, length);
+        if (!ReadHeader(reader, MessageType::SNAPSHOT))
+        {
+            return false;
+        }
+
+        snapshot.roomId = reader.ReadVarint();
+        snapshot.sequence = reader.ReadVarint();
+        uint32_t baselineSequence = reader.ReadVarint();
+        if (baselineSequence != (baseline != nullptr ? baseline->sequence : NO_BASELINE)
+            || (baseline != nullptr && baseline->roomId != snapshot.roomId))
+        {
+            return false;
+        }
+
+        snapshot.serverTime = reader.ReadVarint();
+        CoordinateBits bits = ReadCoordinateBits(reader);
+
+        snapshot.hasSelf = reader.Read(1) != 0;
+        snapshot.inputSequence = NO_INPUT;
+        snapshot.selfX = 0;
+        snapshot.selfY = 0;
+        if (snapshot.hasSelf)
+        {
+            snapshot.inputSequence = reader.ReadVarint();
+            snapshot.selfX = static_cast<int>(reader.Read(bits.x));
+            snapshot.selfY = static_cast<int>(reader.Read(bits.y));
+        }
+
+        uint32_t count = reader.ReadVarint();
+
+        // every entry takes at least one byte of id, don't trust a count
+        // the payload can't possibly hold
+        if (count > reader.GetBitsLeft() / 8)
+        {
+            return false;
+        }
+
+        uint32_t previousId = 0;
+        if (baseline == nullptr)
+        {
+            snapshot.players.reserve(count);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                snapshot.players.push_back(ReadPlayer(reader, previousId, bits));
+            }
+            return !reader.HasOverflowed();
+        }
+
+        // start from the baseline, then apply the changes and removals, all
+        // three lists being sorted by id
+        std::vector<PlayerPosition> changed;
+        changed.reserve(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            changed.push_back(ReadPlayer(reader, previousId, bits));
+        }
+
+        uint32_t removedCount = reader.ReadVarint();
+        if (removedCount > reader.GetBitsLeft() / 8)
+        {
+            return false;
+        }
+
+        std::vector<uint32_t> removed;
+        removed.reserve(removedCount);
+        previousId = 0;
+        for (uint32_t i = 0; i < removedCount; ++i)
+        {
+            previousId += reader.ReadVarint();
+            removed.push_back(previousId);
+        }
+
+        if (reader.HasOverflowed())
+        {
+            return false;
+        }
+
+        size_t change = 0;
+        size_t remove = 0;
+        for (const auto& old : baseline->players)
+        {
+            while (change < changed.size() && changed[change].peerId < old.peerId)
+            {
+                snapshot.players.push_back(changed[change++]);
+            }
+            while (remove < removed.size() && removed[remove] < old.peerId)
+            {
+                remove++;
+            }
+
+            if (remove < removed.size() && removed[remove] == old.peerId)
+            {
+                continue;
+            }
+            if (change < changed.size() && changed[change].peerId == old.peerId)
+            {
+                snapshot.players.push_back(changed[change++]);
+                continue;
+            }
+            snapshot.players.push_back(old);
+        }
+        while (change < changed.size())
+        {
+            snapshot.players.push_back(changed[change++]);
+        }
+
+        return true;
+    }
+
+    bool DecodeSnapshotAck(const uint8_t* data, size_t length, uint32_t& sequence)
+    {
+        BitReader reader(data, length);
+        if (!ReadHeader(reader, MessageType::SNAPSHOT_ACK))
+        {
+            return false;
+        }
+
+        sequence = reader.ReadVarint();
+
+        return !reader.HasOverflowed();
+    }
+
+    bool DecodeJoin(const uint8_t* data, size_t length, uint32_t& roomId, uint32_t& inputSequence)
+    {
+        BitReader reader(data, length);
+        if (!ReadHeader(reader, MessageType::JOIN))
+        {
+            return false;
+        }
+
+        roomId = reader.ReadVarint();
+        inputSequence = reader.ReadVarint();
+
+        return !reader.HasOverflowed();
+    }
+}
@@ -0,0 +1,205 @@
+#include "SendQueue.h"
+
+#include <cstring>
+#include <memory>
+
+static uint8_t GetChannel(DeliveryType type)
+{
+    return type == DeliveryType::RELIABLE ? RELIABLE_CHANNEL : UNRELIABLE_CHANNEL;
+}
+
+static uint32_t GetFlags(uint8_t channelId)
+{
+    return channelId == RELIABLE_CHANNEL ? ENET_PACKET_FLAG_RELIABLE : ENET_PACKET_FLAG_UNSEQUENCED;
+}
+
+static size_t GetVarintSize(size_t value)
+{
+    size_t size = 1;
+    while (value >= 0x80)
+    {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+// writes value as a varint of exactly size bytes. Padding with empty
+// continuation bytes lets a frame header be reserved before the payload
+// length is known
+static void WriteVarint(uint8_t* out, size_t value, size_t size)
+{
+    for (size_t i = 0; i + 1 < size; ++i)
+    {
+        out[i] = static_cast<uint8_t>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out[size - 1] = static_cast<uint8_t>(value);
+}
+
+SendQueue::SendQueue()
+    : m_reservedChannel(NUM_CHANNELS)
+    , m_reservedHeaderSize(0)
+{
+    for (auto& channel : m_channels)
+    {
+        channel.current = nullptr;
+        channel.length = 0;
+    }
+}
+
+SendQueue::~SendQueue()
+{
+    // packets that were never flushed are still ours
+    for (auto& channel : m_channels)
+    {
+        enet_packet_destroy(channel.current);
+        for (ENetPacket* packet : channel.packets)
+        {
+            enet_packet_destroy(packet);
+        }
+    }
+}
+
+void SendQueue::Queue(DeliveryType type, const uint8_t* data, size_t length)
+{
+    uint8_t* buffer = Reserve(type, length);
+    memcpy(buffer, data, length);
+    Commit(length);
+}
+
+uint8_t* SendQueue::Reserve(DeliveryType type, size_t maxLength)
+{
+    uint8_t channelId = GetChannel(type);
+    Channel& channel = m_channels[channelId];
+
+    size_t headerSize = GetVarintSize(maxLength);
+    size_t frameSize = headerSize + maxLength;
+    if (channel.current != nullptr && channel.length + frameSize > channel.current->dataLength)
+    {
+        if (channel.length == 0)
+        {
+            // an empty packet left over from a dropped message is too small,
+            // FinishPacket() would keep it
+            enet_packet_destroy(channel.current);
+            channel.current = nullptr;
+        }
+        else
+        {
+            FinishPacket(channelId);
+        }
+    }
+
+    if (channel.current == nullptr)
+    {
+        // allocated at full size up front, FinishPacket() trims it to what
+        // was actually written without reallocating
+        size_t capacity = frameSize > MAX_BATCH_SIZE ? frameSize : MAX_BATCH_SIZE;
+        channel.current = enet_packet_create(nullptr, capacity, GetFlags(channelId));
+        channel.length = 0;
+    }
+
+    m_reservedChannel = channelId;
+    m_reservedHeaderSize = headerSize;
+    return channel.current->data + channel.length + headerSize;
+}
+
+void SendQueue::Commit(size_t length)
+{
+    if (m_reservedChannel >= NUM_CHANNELS)
+    {
+        return;
+    }
+
+    Channel& channel = m_channels[m_reservedChannel];
+    if (length > 0)
+    {
+        WriteVarint(channel.current->data + channel.length, length, m_reservedHeaderSize);
+        channel.length += m_reservedHeaderSize + length;
+    }
+
+    m_reservedChannel = NUM_CHANNELS;
+    m_reservedHeaderSize = 0;
+}
+
+bool SendQueue::IsEmpty() const
+{
+    for (const auto& channel : m_channels)
+    {
+        if (channel.length > 0 || !channel.packets.empty())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SendQueue::Flush(const std::function<void(uint8_t, ENetPacket*)>& send)
+{
+    for (uint8_t channelId = 0; channelId < NUM_CHANNELS; ++channelId)
+    {
+        FinishPacket(channelId);
+
+        Channel& channel = m_channels[channelId];
+        for (ENetPacket* packet : channel.packets)
+        {
+            send(channelId, packet);
+        }
+        channel.packets.clear();
+    }
+}
+
+void SendQueue::FinishPacket(uint8_t channelId)
+{
+    Channel& channel = m_channels[channelId];
+    if (channel.length == 0)
+    {
+        // nothing written yet, keep the packet for the next batch
+        return;
+    }
+
+    // shrinking only adjusts the length, the payload stays where it is
+    enet_packet_resize(channel.current, channel.length);
+    channel.packets.push_back(channel.current);
+    channel.current = nullptr;
+    channel.length = 0;
+}
+
+bool SendQueue::Unpack(uint32_t peerId, ENetPacket* packet, std::vector<Message>& messages)
+{
+    std::shared_ptr<ENetPacket> owner(packet, enet_packet_destroy);
+
+    const uint8_t* data = packet->data;
+    size_t remaining = packet->dataLength;
+    while (remaining > 0)
+    {
+        // frame length
+        size_t length = 0;
+        uint32_t shift = 0;
+        while (true)
+        {
+            if (remaining == 0 || shift > 28)
+            {
+                return false;
+            }
+            uint8_t byte = *data++;
+            remaining--;
+            length |= static_cast<size_t>(byte & 0x7F) << shift;
+            shift += 7;
+            if ((byte & 0x80) == 0)
+            {
+                break;
+            }
+        }
+
+        if (length > remaining)
+        {
+            return false;
+        }
+
+        messages.emplace_back(peerId, owner, data, length);
+        data += length;
+        remaining -= length;
+    }
+    return true;
+}
@@ -0,0 +1,43 @@
+#include "SnapshotHistory.h"
+
+SnapshotHistory::SnapshotHistory()
+{
+    Clear();
+}
+
+void SnapshotHistory::Store(const Protocol::Snapshot& snapshot)
+{
+    // assigning into the slot reuses the capacity of the one it replaces
+    Protocol::Snapshot& slot = m_snapshots[snapshot.sequence % SIZE];
+    slot.roomId = snapshot.roomId;
+    slot.sequence = snapshot.sequence;
+    slot.serverTime = snapshot.serverTime;
+    slot.players.assign(snapshot.players.begin(), snapshot.players.end());
+    slot.hasSelf = snapshot.hasSelf;
+    slot.selfX = snapshot.selfX;
+    slot.selfY = snapshot.selfY;
+    slot.inputSequence = snapshot.inputSequence;
+}
+
+const Protocol::Snapshot* SnapshotHistory::Find(uint32_t sequence) const
+{
+    if (sequence == Protocol::NO_BASELINE)
+    {
+        return nullptr;
+    }
+
+    const Protocol::Snapshot& slot = m_snapshots[sequence % SIZE];
+    return slot.sequence == sequence ? &slot : nullptr;
+}
+
+void SnapshotHistory::Clear()
+{
+    for (auto& snapshot : m_snapshots)
+    {
+        snapshot.roomId = 0;
+        snapshot.sequence = Protocol::NO_BASELINE;
+        snapshot.players.clear();
+        snapshot.hasSelf = false;
+        snapshot.inputSequence = Protocol::NO_INPUT;
+    }
+}
@@ -0,0 +1,85 @@
+#include "SnapshotReceiver.h"
+
+SnapshotReceiver::SnapshotReceiver()
+    : m_lastSequence(Protocol::NO_BASELINE)
+    , m_roomId(0)
+{
+    m_snapshot.roomId = 0;
+    m_snapshot.sequence = Protocol::NO_BASELINE;
+}
+
+void SnapshotReceiver::Reset(uint32_t roomId)
+{
+    // the new room numbers its snapshots from the start
+    m_history.Clear();
+    m_snapshot.roomId = roomId;
+    m_snapshot.sequence = Protocol::NO_BASELINE;
+    m_snapshot.players.clear();
+    m_snapshot.hasSelf = false;
+    m_snapshot.inputSequence = Protocol::NO_INPUT;
+    m_lastSequence = Protocol::NO_BASELINE;
+    m_roomId = roomId;
+}
+
+bool SnapshotReceiver::Receive(const uint8_t* data, size_t length)
+{
+    uint32_t roomId = 0;
+    uint32_t sequence = 0;
+    uint32_t baselineSequence = 0;
+    if (!Protocol::ReadSnapshotHeader(data, length, roomId, sequence, baselineSequence))
+    {
+        return false;
+    }
+
+    // still in flight from the room we left
+    if (roomId != m_roomId)
+    {
+        return false;
+    }
+
+    // snapshots are unreliable, late ones are older than what we have
+    if (sequence <= m_lastSequence)
+    {
+        return false;
+    }
+
+    const Protocol::Snapshot* baseline = m_history.Find(baselineSequence);
+    if (baselineSequence != Protocol::NO_BASELINE && baseline == nullptr)
+    {
+        // too old to rebuild, the server will move on once newer acks
+        // reach it
+        return false;
+    }
+
+    // decoded aside so a malformed snapshot doesn't clobber the last one
+    if (!Protocol::DecodeSnapshot(data, length, baseline, m_decoded))
+    {
+        return false;
+    }
+    m_snapshot.players.swap(m_decoded.players);
+    m_snapshot.sequence = m_decoded.sequence;
+    m_snapshot.serverTime = m_decoded.serverTime;
+    m_snapshot.hasSelf = m_decoded.hasSelf;
+    m_snapshot.selfX = m_decoded.selfX;
+    m_snapshot.selfY = m_decoded.selfY;
+    m_snapshot.inputSequence = m_decoded.inputSequence;
+
+    m_history.Store(m_snapshot);
+    m_lastSequence = sequence;
+    return true;
+}
+
+const Protocol::Snapshot& SnapshotReceiver::GetSnapshot() const
+{
+    return m_snapshot;
+}
+
+uint32_t SnapshotReceiver::GetLastSequence() const
+{
+    return m_lastSequence;
+}
+
+uint32_t SnapshotReceiver::GetRoomID() const
+{
+    return m_roomId;
+}
@@ -0,0 +1,46 @@
+#include "Tests.h"
+#include "Level.h"
+
+#include <cstdio>
+#include <fstream>
+
+// Checks the rules the server and the bots take from Level: where players
+// spawn and what they can walk into
+
+const char* LEVEL_FILE_NAME = "LevelTest.txt";
+
+// 5x3, a red door right of the spawn. Rows follow each other without line
+// breaks, as in the game's files
+const char* LEVEL_FILE = "5\n3\n+---+|@R |+---+";
+
+void TestWallsAndDoors()
+{
+    {
+        std::ofstream levelFile(LEVEL_FILE_NAME);
+        levelFile << LEVEL_FILE;
+    }
+
+    Level level;
+    Check(level.Load(LEVEL_FILE_NAME, nullptr, nullptr), "level: loads");
+    remove(LEVEL_FILE_NAME);
+
+    Check(level.GetSpawnX() == 1 && level.GetSpawnY() == 1, "level: spawn");
+    Check(!level.IsWall(1, 1) && !level.IsBlocked(1, 1), "level: spawn is free");
+    Check(level.IsWall(0, 1) && level.IsWall(2, 0), "level: walls");
+    Check(level.IsWall(-1, 1) && level.IsWall(5, 1) && level.IsWall(1, 3), "level: outside is wall");
+    Check(!level.IsWall(2, 1) && level.IsBlocked(2, 1), "level: a door only blocks");
+    Check(!level.IsBlocked(3, 1), "level: past the door is free");
+}
+
+void TestMissingFile()
+{
+    Level level;
+    Check(!level.Load("NoSuchLevel.txt", nullptr, nullptr), "level: missing file fails");
+    Check(!level.GetWarnings().empty(), "level: missing file warns");
+}
+
+void RunLevelTests()
+{
+    TestWallsAndDoors();
+    TestMissingFile();
+}
@@ -0,0 +1,78 @@
+#include "Tests.h"
+#include "MovePredictor.h"
+#include "Protocol.h"
+
+#include <vector>
+
+// Checks that MovePredictor gets every step to the server, also when more
+// are pending than an INPUT message carries
+
+const size_t STEP_COUNT = 3 * Protocol::MAX_INPUTS_PER_MESSAGE + 5;
+
+// what Room::ApplyInput() keeps of a client: the last sequence applied,
+// anything not newer is a resend
+struct FakeServer
+{
+    uint32_t lastSequence = Protocol::NO_INPUT;
+    std::vector<uint32_t> applied;
+
+    void Apply(const Protocol::Input* inputs, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (inputs[i].sequence > lastSequence)
+            {
+                applied.push_back(inputs[i].sequence);
+                lastSequence = inputs[i].sequence;
+            }
+        }
+    }
+};
+
+// every step is pushed before anything is acknowledged, like typing fast
+// while the round trip spikes
+void TestBacklogIsSentOldestFirst()
+{
+    MovePredictor predictor;
+    uint32_t joinSequence = predictor.Restart();
+
+    FakeServer server;
+    server.lastSequence = joinSequence;
+
+    for (size_t i = 0; i < STEP_COUNT; ++i)
+    {
+        predictor.Push(Protocol::Direction::RIGHT);
+    }
+
+    Protocol::Input inputs[Protocol::MAX_INPUTS_PER_MESSAGE];
+    for (size_t message = 0; message < STEP_COUNT && predictor.GetPendingCount() > 0; ++message)
+    {
+        size_t count = predictor.GetPending(inputs, Protocol::MAX_INPUTS_PER_MESSAGE);
+        server.Apply(inputs, count);
+
+        Protocol::Snapshot snapshot;
+        snapshot.hasSelf = true;
+        snapshot.selfX = static_cast<int>(server.applied.size());
+        snapshot.inputSequence = server.lastSequence;
+        int x = 0;
+        int y = 0;
+        predictor.Reconcile(snapshot, [](int, int) { return false; }, x, y);
+        Check(x == static_cast<int>(STEP_COUNT), "backlog: prediction keeps every step");
+    }
+
+    Check(predictor.GetPendingCount() == 0, "backlog: everything acknowledged");
+    Check(server.applied.size() == STEP_COUNT, "backlog: every step applied");
+    for (size_t i = 0; i < server.applied.size(); ++i)
+    {
+        if (server.applied[i] != joinSequence + 1 + i)
+        {
+            Check(false, "backlog: steps applied in order without gaps");
+            break;
+        }
+    }
+}
+
+void RunMovePredictorTests()
+{
+    TestBacklogIsSentOldestFirst();
+}
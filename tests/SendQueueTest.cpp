@@ -0,0 +1,83 @@
+#include "Tests.h"
+#include "SendQueue.h"
+
+#include <enet/enet.h>
+
+#include <cstring>
+#include <vector>
+
+// Checks that SendQueue hands out room for as many bytes as it was asked
+// for
+
+const size_t LARGE_MESSAGE_SIZE = 3000;
+
+std::vector<Message> FlushAndUnpack(SendQueue& queue)
+{
+    std::vector<Message> messages;
+    queue.Flush([&messages](uint8_t, ENetPacket* packet)
+    {
+        SendQueue::Unpack(0, packet, messages);
+    });
+    return messages;
+}
+
+// a dropped message leaves an empty packet behind, a larger one reserved
+// after it must not be written into that packet
+void TestLargeReserveAfterDroppedMessage()
+{
+    SendQueue queue;
+    queue.Reserve(DeliveryType::UNRELIABLE, 10);
+    queue.Commit(0);
+
+    uint8_t* buffer = queue.Reserve(DeliveryType::UNRELIABLE, LARGE_MESSAGE_SIZE);
+    memset(buffer, 0xAB, LARGE_MESSAGE_SIZE);
+    queue.Commit(LARGE_MESSAGE_SIZE);
+
+    std::vector<Message> messages = FlushAndUnpack(queue);
+    Check(messages.size() == 1, "large reserve after commit(0): one message");
+    Check(!messages.empty() && messages[0].GetDataLength() == LARGE_MESSAGE_SIZE, "large reserve after commit(0): length");
+}
+
+// the same with the empty packet carried over a flush, like a room where
+// every client was up to date
+void TestLargeReserveAfterFlush()
+{
+    SendQueue queue;
+    queue.Reserve(DeliveryType::UNRELIABLE, 10);
+    queue.Commit(0);
+    Check(FlushAndUnpack(queue).empty(), "dropped message: nothing sent");
+
+    uint8_t* buffer = queue.Reserve(DeliveryType::UNRELIABLE, LARGE_MESSAGE_SIZE);
+    memset(buffer, 0xCD, LARGE_MESSAGE_SIZE);
+    queue.Commit(LARGE_MESSAGE_SIZE);
+
+    std::vector<Message> messages = FlushAndUnpack(queue);
+    Check(messages.size() == 1, "large reserve after flush: one message");
+    Check(!messages.empty() && messages[0].GetDataLength() == LARGE_MESSAGE_SIZE, "large reserve after flush: length");
+}
+
+// small messages still share one packet
+void TestBatching()
+{
+    SendQueue queue;
+    const uint8_t data[] = { 1, 2, 3 };
+    queue.Queue(DeliveryType::RELIABLE, data, sizeof(data));
+    queue.Queue(DeliveryType::RELIABLE, data, sizeof(data));
+
+    int packets = 0;
+    std::vector<Message> messages;
+    queue.Flush([&](uint8_t, ENetPacket* packet)
+    {
+        packets++;
+        SendQueue::Unpack(0, packet, messages);
+    });
+    Check(packets == 1, "batching: one packet");
+    Check(messages.size() == 2, "batching: two messages");
+}
+
+void RunSendQueueTests()
+{
+    TestLargeReserveAfterDroppedMessage();
+    TestLargeReserveAfterFlush();
+    TestBatching();
+}
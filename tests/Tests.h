@@ -0,0 +1,8 @@
+#pragma once
+
+// counts a failed check, the tests exit with 1 if there was any
+void Check(bool condition, const char* what);
+
+void RunSendQueueTests();
+void RunMovePredictorTests();
+void RunLevelTests();
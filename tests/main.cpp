@@ -0,0 +1,41 @@
+#include "Tests.h"
+
+#include <enet/enet.h>
+
+#include <iostream>
+
+// Runs every test, printing the checks that fail. Exits with 1 if any
+// check fails
+
+int g_failures = 0;
+
+void Check(bool condition, const char* what)
+{
+    if (!condition)
+    {
+        std::cout << "FAILED: " << what << std::endl;
+        g_failures++;
+    }
+}
+
+int main()
+{
+    if (enet_initialize() != 0)
+    {
+        std::cout << "An error occurred while initializing ENet." << std::endl;
+        return 1;
+    }
+
+    RunSendQueueTests();
+    RunMovePredictorTests();
+    RunLevelTests();
+
+    enet_deinitialize();
+
+    if (g_failures > 0)
+    {
+        return 1;
+    }
+    std::cout << "All tests passed." << std::endl;
+    return 0;
+}